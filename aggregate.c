@@ -0,0 +1,72 @@
+#include "aggregate.h"
+
+#include <errno.h>
+#include <math.h>
+
+void aggregate_init(struct aggregate *a)
+{
+    a->count = 0;
+    a->base = BaseUnitNone;
+    a->sum = 0;
+    a->compensation = 0;
+    a->min = INFINITY;
+    a->max = -INFINITY;
+    sketch_init(&a->sketch, AGGREGATE_ACCURACY);
+}
+
+/// Add @c x to the compensated sum of @c a.
+static void accumulate(struct aggregate *a, double x)
+{
+    double t = a->sum + x;
+
+    a->compensation += fabs(a->sum) >= fabs(x) ? (a->sum - t) + x : (x - t) + a->sum;
+    a->sum = t;
+}
+
+int aggregate_add(struct aggregate *a, double quantity, enum base base)
+{
+    int r = a->count && base != a->base ? -EPERM : sketch_add(&a->sketch, quantity);
+
+    if (r) {
+        return r;
+    }
+
+    a->count++;
+    a->base = base;
+    accumulate(a, quantity);
+    a->min = fmin(a->min, quantity);
+    a->max = fmax(a->max, quantity);
+    return 0;
+}
+
+int aggregate_merge(struct aggregate *a, const struct aggregate *b)
+{
+    int r = a->count && b->count && a->base != b->base ? -EPERM : sketch_merge(&a->sketch, &b->sketch);
+
+    if (r) {
+        return r;
+    }
+
+    a->base = a->count ? a->base : b->base;
+    a->count += b->count;
+    accumulate(a, b->sum);
+    accumulate(a, b->compensation);
+    a->min = fmin(a->min, b->min);
+    a->max = fmax(a->max, b->max);
+    return 0;
+}
+
+double aggregate_sum(const struct aggregate *a)
+{
+    return a->sum + a->compensation;
+}
+
+double aggregate_mean(const struct aggregate *a)
+{
+    return a->count ? aggregate_sum(a) / (double)a->count : NAN;
+}
+
+double aggregate_quantile(const struct aggregate *a, double q)
+{
+    return sketch_quantile(&a->sketch, q);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "sketch.h"
+#include "unit.h"
+
+#include <stddef.h>
+
+/// Relative accuracy of quantiles.
+#define AGGREGATE_ACCURACY 0.01
+
+/// Streaming summary of quantities of one base unit, in constant memory.
+/// Quantities may be in any one unit of that base, such as the unit that statistics are printed in; quantiles are
+/// accurate relative to quantities in that unit, which may be negative.
+/// Partial aggregates, for example one per thread, may be merged.
+struct aggregate {
+    /// Number of quantities.
+    size_t count;
+    /// Base unit of quantities; valid if @c count is not zero.
+    enum base base;
+    /// Sum, with compensation for rounding error (Neumaier).
+    double sum;
+    double compensation;
+    /// Least and greatest quantity.
+    double min;
+    double max;
+    /// Distribution, for quantiles.
+    struct sketch sketch;
+};
+
+/// Initialize empty aggregate @c a.
+void aggregate_init(struct aggregate *a);
+
+/// Add @c quantity of @c base to @c a.
+/// @return Zero on success, negative otherwise.
+/// @return -EPERM If @c base differs from that of quantities already added.
+/// @return -EINVAL If @c quantity is not finite.
+int aggregate_add(struct aggregate *a, double quantity, enum base base);
+
+/// Merge @c b into @c a.
+/// @return Zero on success, negative otherwise.
+/// @return -EPERM If the bases of @c a and @c b differ.
+int aggregate_merge(struct aggregate *a, const struct aggregate *b);
+
+/// @return Sum of quantities of @c a, in their unit.
+double aggregate_sum(const struct aggregate *a);
+
+/// @return Mean of quantities of @c a, in their unit, or NaN if empty.
+double aggregate_mean(const struct aggregate *a);
+
+/// @return Estimate of quantile @c q of quantities of @c a, in their unit, within AGGREGATE_ACCURACY,
+/// or NaN if empty or if @c q is not between zero and one.
+double aggregate_quantile(const struct aggregate *a, double q);
@@ -0,0 +1,792 @@
+// Benchmarks.
+
+#include "extract.h"
+#include "label.h"
+#include "parser.h"
+#include "unit.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <linux/perf_event.h>
+#include <locale.h>
+#include <spawn.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <wctype.h>
+
+extern char **environ;
+
+/// Base of each built-in unit.
+static const enum base bases[PresentationUnitCount] = {
+#define u(symbol, name, base_, scale) [name] = base_ ,
+#include "unit.hi"
+};
+
+/// Built-in labels.
+static const struct {
+    const wchar_t *text;
+    enum unit unit;
+} labels[] = {
+#define l(label, unit) { label, unit },
+#include "label.hi"
+};
+
+/// Parts of mixed-radix units.
+static const struct {
+    enum unit unit;
+    enum unit part;
+    int radix;
+} parts[] = {
+#define r(name, part, symbol, radix, denominator) { name, part, radix },
+#include "unit.hi"
+};
+
+/// Time taken by one run of a program.
+struct sample {
+    /// Nanoseconds from start to first output.
+    long long first;
+    /// Nanoseconds from start to exit.
+    long long exit;
+    /// Nanoseconds of processor time, user and system.
+    long long cpu;
+};
+
+__attribute__((noreturn))
+static void synopsis(void)
+{
+    fprintf(stderr,
+        "usage: benchmark startup [-n RUNS] PROGRAM [ARG]...\n"
+        "       benchmark corpus [-d DISTINCT] [-n RECORDS] [-s SEED]\n"
+        "       benchmark speedup [-n RUNS] [-c ARG] -i FILE BASELINE CANDIDATE [ARG]...\n"
+        "       benchmark counters [-n OPERATIONS] [FUNCTION]...\n");
+    exit(EXIT_FAILURE);
+}
+
+/// @return Monotonic time in nanoseconds.
+static long long now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/// Run program @c argv once, with its output to a pipe, and its input from file @c input unless it is NULL.
+/// @return Zero on success, negative otherwise.
+static int run(char **argv, const char *input, struct sample *sample)
+{
+    posix_spawn_file_actions_t actions;
+    struct rusage usage;
+    char buffer[4096];
+    long long start;
+    pid_t pid;
+    ssize_t n;
+    int status;
+    int fd[2];
+    int r;
+
+    if (pipe(fd)) {
+        return -errno;
+    }
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fd[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fd[0]);
+    posix_spawn_file_actions_addclose(&actions, fd[1]);
+    if (input) {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, input, O_RDONLY, 0);
+    }
+
+    start = now();
+    r = -posix_spawn(&pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fd[1]);
+
+    if (r) {
+        close(fd[0]);
+        return r;
+    }
+
+    n = read(fd[0], buffer, 1);
+    sample->first = now() - start;
+
+    while (n > 0) {
+        n = read(fd[0], buffer, sizeof(buffer));
+    }
+
+    close(fd[0]);
+    wait4(pid, &status, 0, &usage);
+    sample->exit = now() - start;
+    sample->cpu = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000LL
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000LL;
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS ? 0 : -ECHILD;
+}
+
+static int compare(const void *a, const void *b)
+{
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+/// Print summary of @c n times, which are sorted.
+static void summarize(const char *name, long long *times, size_t n)
+{
+    qsort(times, n, sizeof(*times), compare);
+    printf("  %-20s min %8.1f us  median %8.1f us  p90 %8.1f us\n",
+        name, times[0] / 1e3, times[n / 2] / 1e3, times[n * 9 / 10] / 1e3);
+}
+
+/// Measure time from starting program @c argv until its first output, and until it exits.
+static int startup(int argc, char **argv)
+{
+    size_t runs = 1000;
+    int ch;
+
+    while ((ch = getopt(argc, argv, "+n:")) != -1) {
+        switch (ch) {
+            case 'n':
+                runs = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                synopsis();
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc == 0 || runs == 0) {
+        synopsis();
+    }
+
+    long long *first = calloc(runs, sizeof(*first));
+    long long *exit = calloc(runs, sizeof(*exit));
+    if (!first || !exit) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < runs; ++i) {
+        struct sample sample;
+        int r = run(argv, NULL, &sample);
+
+        if (r) {
+            fprintf(stderr, "%s: %s\n", argv[0], strerror(-r));
+            return EXIT_FAILURE;
+        }
+
+        first[i] = sample.first;
+        exit[i] = sample.exit;
+    }
+
+    printf("startup:");
+    for (int i = 0; i < argc; ++i) {
+        printf(" %s", argv[i]);
+    }
+    printf(" (%zu runs)\n", runs);
+    summarize("first output", first, runs);
+    summarize("exit", exit, runs);
+
+    free(first);
+    free(exit);
+    return EXIT_SUCCESS;
+}
+
+/// @return Pseudo-random number less than @c n, from xorshift @c state.
+static uint64_t pick(uint64_t *state, uint64_t n)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state % n;
+}
+
+/// @return Label of @c unit, chosen at random.
+static const wchar_t *label_of(uint64_t *state, enum unit unit)
+{
+    size_t n = 0;
+    size_t k;
+
+    for (size_t i = 0; i < sizeof(labels) / sizeof(*labels); ++i) {
+        n += labels[i].unit == unit;
+    }
+
+    k = pick(state, n);
+    for (size_t i = 0; ; ++i) {
+        if (labels[i].unit == unit && !k--) {
+            return labels[i].text;
+        }
+    }
+}
+
+/// @return Unit of @c base, chosen at random from those with labels.
+static enum unit unit_of(uint64_t *state, enum base base)
+{
+    for (;;) {
+        enum unit unit = labels[pick(state, sizeof(labels) / sizeof(*labels))].unit;
+
+        if (bases[unit] == base) {
+            return unit;
+        }
+    }
+}
+
+/// Print @c n records of "QUANTITY FROM TO", generated from @c seed, for unico option -b.
+/// Records mix every label, compound quantities of mixed-radix units and lists of destinations, so that a
+/// profile of converting them covers label lookup, parsing, conversion and rendering.
+/// If @c distinct is not zero, records are drawn from that many distinct records, as in exports of quantized
+/// readings.
+static void records(uint64_t seed, size_t n, size_t distinct)
+{
+    uint64_t draw = seed ? seed : 1;
+    uint64_t state = draw;
+
+    for (size_t i = 0; i < n; ++i) {
+        // A distinct record is generated from a state of its own.
+        state = distinct ? (pick(&draw, distinct) + 1) * UINT64_C(0x9e3779b97f4a7c15) : state;
+
+        size_t kind = pick(&state, 10);
+        size_t j = pick(&state, sizeof(parts) / sizeof(*parts) - 1);
+        enum unit from = labels[pick(&state, sizeof(labels) / sizeof(*labels))].unit;
+
+        if (kind < 2 && parts[j].unit == parts[j + 1].unit) {
+            // Compound quantity, from part j to the least part.
+            from = parts[j].part;
+            printf("%d %ls", (int)pick(&state, 100), label_of(&state, from));
+            for (++j; j < sizeof(parts) / sizeof(*parts) && parts[j].unit == parts[j - 1].unit; ++j) {
+                printf(" %d %ls", (int)pick(&state, (uint64_t)parts[j].radix), label_of(&state, parts[j].part));
+            }
+        } else {
+            printf("%.6g %ls", ((double)pick(&state, 2000000) - 500000) / 1000, label_of(&state, from));
+        }
+
+        printf(" %ls", label_of(&state, unit_of(&state, bases[from])));
+        for (size_t k = kind == 9 ? 2 : 0; k; --k) {
+            printf(",%ls", label_of(&state, unit_of(&state, bases[from])));
+        }
+        printf("\n");
+    }
+}
+
+/// Print a corpus of records representative of bulk conversion.
+static int corpus(int argc, char **argv)
+{
+    size_t n = 100000;
+    size_t distinct = 0;
+    uint64_t seed = 1;
+    int ch;
+
+    while ((ch = getopt(argc, argv, "+d:n:s:")) != -1) {
+        switch (ch) {
+            case 'd':
+                distinct = strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                n = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                synopsis();
+        }
+    }
+
+    if (optind != argc) {
+        synopsis();
+    }
+
+    // Labels are written as UTF-8 whatever the environment, so the corpus is reproducible.
+    if (!setlocale(LC_CTYPE, "C.UTF-8")) {
+        fprintf(stderr, "Cannot select locale C.UTF-8.\n");
+        return EXIT_FAILURE;
+    }
+
+    records(seed, n, distinct);
+    return fflush(stdout) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/// Measure time for programs BASELINE and CANDIDATE, given the same arguments, and CANDIDATE also argument ARG of
+/// option -c, to process a file on standard input, in alternate runs, and report the speedup of CANDIDATE.
+/// The share of elapsed time that each spends on the processor shows whether it waits for input and output.
+static int speedup(int argc, char **argv)
+{
+    const char *input = NULL;
+    char *extra = NULL;
+    size_t runs = 5;
+    int ch;
+
+    while ((ch = getopt(argc, argv, "+n:c:i:")) != -1) {
+        switch (ch) {
+            case 'n':
+                runs = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                extra = optarg;
+                break;
+            case 'i':
+                input = optarg;
+                break;
+            default:
+                synopsis();
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (argc < 2 || runs == 0 || !input) {
+        synopsis();
+    }
+
+    // Arguments of each program follow both programs.
+    char *programs[2] = { argv[0], argv[1] };
+    char *command[argc + 1];
+    long long *times[2] = { calloc(runs, sizeof(long long)), calloc(runs, sizeof(long long)) };
+    long long elapsed[2] = { 0 };
+    long long cpu[2] = { 0 };
+    if (!times[0] || !times[1]) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < runs; ++i) {
+        for (size_t p = 0; p < 2; ++p) {
+            struct sample sample;
+            int k = 0;
+            int r;
+
+            command[k++] = programs[p];
+            if (p && extra) {
+                command[k++] = extra;
+            }
+            for (int j = 2; j < argc; ++j) {
+                command[k++] = argv[j];
+            }
+            command[k] = NULL;
+
+            r = run(command, input, &sample);
+            if (r) {
+                fprintf(stderr, "%s: %s\n", programs[p], strerror(-r));
+                return EXIT_FAILURE;
+            }
+
+            times[p][i] = sample.exit;
+            elapsed[p] += sample.exit;
+            cpu[p] += sample.cpu;
+        }
+    }
+
+    char candidate[256];
+    snprintf(candidate, sizeof(candidate), "%s%s%s", programs[1], extra ? " " : "", extra ? extra : "");
+    const char *names[2] = { programs[0], candidate };
+
+    printf("speedup: %s (%zu runs)\n", input, runs);
+    summarize(names[0], times[0], runs);
+    summarize(names[1], times[1], runs);
+    printf("  %-20s %.2fx (median)\n", "speedup", (double)times[0][runs / 2] / (double)times[1][runs / 2]);
+    for (size_t p = 0; p < 2; ++p) {
+        printf("  %-20s cpu %.0f%% of elapsed\n", names[p], 100.0 * (double)cpu[p] / (double)elapsed[p]);
+    }
+
+    free(times[0]);
+    free(times[1]);
+    return EXIT_SUCCESS;
+}
+
+/// Event counted by perf_event_open.
+struct event {
+    /// Name.
+    const char *name;
+    /// Type and configuration of perf_event_attr.
+    uint32_t type;
+    uint64_t config;
+};
+
+static const struct event events[] = {
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { "L1d-misses", PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+    { "LLC-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+};
+
+#define EVENT_COUNT (sizeof(events) / sizeof(*events))
+
+/// Counters of this thread, one for each event, or -1 where the event cannot be counted.
+/// Each is opened separately, so that those available are counted when others are not, as in a container or
+/// virtual machine without a performance monitoring unit.
+static int counters[EVENT_COUNT];
+
+/// Open a counter for each event.
+/// @return Number of counters opened.
+static size_t counters_open(void)
+{
+    size_t n = 0;
+    int error = 0;
+
+    for (size_t e = 0; e < EVENT_COUNT; ++e) {
+        struct perf_event_attr attr = {
+            .size = sizeof(attr),
+            .type = events[e].type,
+            .config = events[e].config,
+            .disabled = 1,
+            .exclude_kernel = 1,
+            .exclude_hv = 1,
+            .read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING,
+        };
+
+        counters[e] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        error = counters[e] < 0 ? errno : error;
+        n += counters[e] >= 0;
+    }
+
+    if (n < EVENT_COUNT) {
+        fprintf(stderr, "perf_event_open: %s; %s.\n", strerror(error),
+            n ? "some counters are not available" : "counting time only");
+    }
+
+    return n;
+}
+
+/// Close the counters opened.
+static void counters_close(void)
+{
+    for (size_t e = 0; e < EVENT_COUNT; ++e) {
+        if (counters[e] >= 0) {
+            close(counters[e]);
+        }
+        counters[e] = -1;
+    }
+}
+
+/// Start counting.
+static void counters_start(void)
+{
+    for (size_t e = 0; e < EVENT_COUNT; ++e) {
+        if (counters[e] >= 0) {
+            ioctl(counters[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+/// Stop counting, and store the count of each event in @c counts, or -1 if it was not counted.
+/// A count is scaled by the share of the time it was counted, if the counters were multiplexed.
+static void counters_stop(double *counts)
+{
+    for (size_t e = 0; e < EVENT_COUNT; ++e) {
+        uint64_t value[3] = { 0 };
+
+        if (counters[e] >= 0) {
+            ioctl(counters[e], PERF_EVENT_IOC_DISABLE, 0);
+        }
+
+        bool counted = counters[e] >= 0 && read(counters[e], value, sizeof(value)) == sizeof(value) && value[2];
+        counts[e] = counted ? (double)value[0] * (double)value[1] / (double)value[2] : -1;
+    }
+}
+
+/// Number of quantities converted by each call of an array conversion.
+#define ARRAY_SIZE 256
+
+/// Inputs of the functions measured, prepared before counting.
+static struct {
+    /// Copies of built-in labels, and of their upper case.
+    wchar_t label[sizeof(labels) / sizeof(*labels)][32];
+    wchar_t upper[sizeof(labels) / sizeof(*labels)][32];
+    /// Conversion between each unit and the next of the same base.
+    struct unit_conversion conversion[PresentationUnitCount];
+    /// Conversion of milli-units, as double and in fixed point, and quantities that they convert.
+    struct unit_conversion milli;
+    struct unit_conversion_fixed fixed;
+    double doubles[ARRAY_SIZE];
+    int64_t integers[ARRAY_SIZE];
+    int32_t narrow[ARRAY_SIZE];
+    /// Parser.
+    struct parser *parser;
+    /// Extractor, and text from which it extracts.
+    struct extractor *extractor;
+    const char *text;
+} inputs;
+
+/// Records parsed by measure_parser.
+static const wchar_t *const records_parsed[] = {
+    L"6'3\" m", L"1 pt ml", L"7 lbs 14 oz kg", L"1 bar Pa,hPa,psi", L"20 °C °F", L"12.5 ± 0.1 mm in",
+};
+
+static double measure_label_lookup(size_t i)
+{
+    wchar_t *p;
+    return label_lookup(inputs.label[i % (sizeof(labels) / sizeof(*labels))], &p);
+}
+
+static double measure_label_lookup_tolerant(size_t i)
+{
+    wchar_t *p;
+    return label_lookup_tolerant(inputs.upper[i % (sizeof(labels) / sizeof(*labels))], &p);
+}
+
+static double measure_unit_to_base(size_t i)
+{
+    enum base base;
+    return unit_to_base((double)i, (enum unit)(PresentationUnitNone + 1 + i % (PresentationUnitCount - 1)), &base);
+}
+
+static double measure_base_to_unit(size_t i)
+{
+    enum unit unit = (enum unit)(PresentationUnitNone + 1 + i % (PresentationUnitCount - 1));
+    double quantity = 0;
+
+    base_to_unit((double)i, bases[unit], unit, &quantity);
+    return quantity;
+}
+
+static double measure_unit_convert(size_t i)
+{
+    return unit_convert(&inputs.conversion[1 + i % (PresentationUnitCount - 1)], (double)i);
+}
+
+static double measure_unit_convert_fixed(size_t i)
+{
+    int64_t quantity;
+
+    unit_convert_fixed(&inputs.fixed, (int64_t)i, &quantity);
+    return (double)quantity;
+}
+
+static double measure_unit_convert_array(size_t i)
+{
+    unit_convert_array(&inputs.milli, inputs.doubles, inputs.doubles, ARRAY_SIZE);
+    return inputs.doubles[i % ARRAY_SIZE];
+}
+
+static double measure_unit_convert_fixed_array(size_t i)
+{
+    unit_convert_fixed_array(&inputs.fixed, inputs.integers, inputs.integers, ARRAY_SIZE);
+    return (double)inputs.integers[i % ARRAY_SIZE];
+}
+
+static double measure_unit_convert_fixed_array32(size_t i)
+{
+    unit_convert_fixed_array32(&inputs.fixed, inputs.narrow, inputs.narrow, ARRAY_SIZE);
+    return inputs.narrow[i % ARRAY_SIZE];
+}
+
+static double measure_unit_format(size_t i)
+{
+    char buffer[64];
+    return unit_format((double)i / 7, (enum unit)(PresentationUnitNone + 1 + i % (PresentationUnitCount - 1)),
+        buffer, sizeof(buffer));
+}
+
+static double measure_parser_add(size_t i)
+{
+    wchar_t record[32];
+    wchar_t *term;
+    struct parser_data data = { 0 };
+
+    wcscpy(record, records_parsed[i % (sizeof(records_parsed) / sizeof(*records_parsed))]);
+    parser_add(inputs.parser, record, &term, &data);
+    return data.quantity;
+}
+
+static double measure_extractor_find(size_t i)
+{
+    struct extract_match match = { 0 };
+    size_t offset = 0;
+    size_t size = strlen(inputs.text);
+    double sum = (double)i;
+
+    while (extractor_find(inputs.extractor, inputs.text, size, &offset, &match)) {
+        sum += match.quantity;
+    }
+
+    return sum;
+}
+
+/// Function measured.
+static const struct {
+    const char *name;
+    double (*measure)(size_t i);
+} functions[] = {
+    { "label_lookup", measure_label_lookup },
+    { "label_lookup_tolerant", measure_label_lookup_tolerant },
+    { "unit_to_base", measure_unit_to_base },
+    { "base_to_unit", measure_base_to_unit },
+    { "unit_convert", measure_unit_convert },
+    { "unit_convert_fixed", measure_unit_convert_fixed },
+    { "unit_convert_array", measure_unit_convert_array },
+    { "unit_convert_fixed_array", measure_unit_convert_fixed_array },
+    { "unit_convert_fixed_array32", measure_unit_convert_fixed_array32 },
+    { "unit_format", measure_unit_format },
+    { "parser_add", measure_parser_add },
+    { "extractor_find", measure_extractor_find },
+};
+
+/// Prepare the inputs of the functions measured.
+/// @return False if memory is exhausted.
+static bool prepare(void)
+{
+    for (size_t i = 0; i < sizeof(labels) / sizeof(*labels); ++i) {
+        wcsncpy(inputs.label[i], labels[i].text, 31);
+        for (size_t j = 0; j < 32; ++j) {
+            inputs.upper[i][j] = (wchar_t)towupper((wint_t)inputs.label[i][j]);
+        }
+    }
+
+    for (size_t u = 1; u < PresentationUnitCount; ++u) {
+        size_t v = u % (PresentationUnitCount - 1) + 1;
+
+        while (bases[v] != bases[u]) {
+            v = v % (PresentationUnitCount - 1) + 1;
+        }
+        unit_conversion((enum unit)u, (enum unit)v, &inputs.conversion[u]);
+    }
+
+    // Repeated conversion of degrees Fahrenheit to degrees Celsius converges to -40, so quantities stay in range.
+    unit_conversion(PresentationUnitDegreesFahrenheit, PresentationUnitDegreesCelsius, &inputs.milli);
+    unit_conversion_fixed(PresentationUnitDegreesFahrenheit, -3, PresentationUnitDegreesCelsius, -3, &inputs.fixed);
+    for (size_t i = 0; i < ARRAY_SIZE; ++i) {
+        inputs.doubles[i] = (double)i * 0.125;
+        inputs.integers[i] = (int64_t)i * 125;
+        inputs.narrow[i] = (int32_t)i * 125;
+    }
+
+    inputs.parser = parser_new();
+    inputs.extractor = extractor_new();
+    inputs.text = "Replaced the 2 ft 3 in hose at 35 psi; pump weighs 7 lb 14 oz, runs at 60 °C and 1.5 bar, "
+        "serial 4471-B, 12 m from the 3/4\" valve.";
+    return inputs.parser && inputs.extractor;
+}
+
+/// Print count @c x per operation of @c n, or "-" if it was not counted.
+static void per_operation(double x, size_t n, int width)
+{
+    if (x < 0) {
+        printf(" %*s", width, "-");
+    } else {
+        printf(" %*.2f", width, x / (double)n);
+    }
+}
+
+/// Measure FUNCTION, or every function, for OPERATIONS calls, and report time, hardware events and instructions per
+/// cycle for each call.
+static int count(int argc, char **argv)
+{
+    size_t n = 1000000;
+    volatile double sink = 0;
+    int ch;
+
+    while ((ch = getopt(argc, argv, "+n:")) != -1) {
+        switch (ch) {
+            case 'n':
+                n = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                synopsis();
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (n == 0) {
+        synopsis();
+    }
+
+    setlocale(LC_ALL, "C.UTF-8");
+    if (!prepare()) {
+        perror("prepare");
+        return EXIT_FAILURE;
+    }
+
+    size_t opened = counters_open();
+
+    printf("counters: %zu operations, %zu of %zu events\n", n, opened, EVENT_COUNT);
+    printf("  %-26s %8s %10s %10s %6s %10s %10s %10s\n", "function", "ns", "cycles", "instr", "IPC", "br-miss",
+        "L1d-miss", "LLC-miss");
+
+    for (size_t f = 0; f < sizeof(functions) / sizeof(*functions); ++f) {
+        bool selected = !argc;
+        double counts[EVENT_COUNT];
+        long long start;
+        long long elapsed;
+
+        for (int i = 0; i < argc; ++i) {
+            selected = selected || !strcmp(argv[i], functions[f].name);
+        }
+        if (!selected) {
+            continue;
+        }
+
+        // Warm caches and predictors, then count.
+        for (size_t i = 0; i < n / 10; ++i) {
+            sink += functions[f].measure(i);
+        }
+
+        start = now();
+        counters_start();
+        for (size_t i = 0; i < n; ++i) {
+            sink += functions[f].measure(i);
+        }
+        counters_stop(counts);
+        elapsed = now() - start;
+
+        printf("  %-26s %8.1f", functions[f].name, (double)elapsed / (double)n);
+        per_operation(counts[0], n, 10);
+        per_operation(counts[1], n, 10);
+        if (counts[0] > 0 && counts[1] >= 0) {
+            printf(" %6.2f", counts[1] / counts[0]);
+        } else {
+            printf(" %6s", "-");
+        }
+        per_operation(counts[2], n, 10);
+        per_operation(counts[3], n, 10);
+        per_operation(counts[4], n, 10);
+        printf("\n");
+    }
+
+    (void)sink;
+    counters_close();
+    parser_delete(inputs.parser);
+    extractor_delete(inputs.extractor);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        synopsis();
+    }
+
+    if (!strcmp(argv[1], "startup")) {
+        return startup(argc - 1, argv + 1);
+    }
+
+    if (!strcmp(argv[1], "corpus")) {
+        return corpus(argc - 1, argv + 1);
+    }
+
+    if (!strcmp(argv[1], "speedup")) {
+        return speedup(argc - 1, argv + 1);
+    }
+
+    if (!strcmp(argv[1], "counters")) {
+        return count(argc - 1, argv + 1);
+    }
+
+    synopsis();
+}
@@ -0,0 +1,190 @@
+#include "cache.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Entries are of fixed size, holding their key and value, so that a hit is a probe of the index and a comparison of
+// the key, and the cache allocates nothing after it is made.
+// The index is an open-addressed table of entry numbers, probed linearly, at most half full.
+
+/// Entry.
+struct entry {
+    /// Hash of key.
+    uint64_t hash;
+    /// Length of key, and of value, which follows it in @c bytes.
+    uint16_t key_length;
+    uint16_t length;
+    /// True if found since the clock hand last passed.
+    bool referenced;
+    /// Key and value.
+    char bytes[CACHE_ENTRY_MAX];
+};
+
+struct cache {
+    /// Entries, of which @c count are used.
+    struct entry *entries;
+    size_t count;
+    size_t capacity;
+    /// Next entry considered for eviction.
+    size_t hand;
+    /// Index: entry number plus one, or zero if empty.
+    uint32_t *slots;
+    /// Number of slots less one; the number of slots is a power of two.
+    size_t mask;
+    /// Counters.
+    struct cache_metrics metrics;
+};
+
+int cache_new(size_t capacity, struct cache **out)
+{
+    struct cache *c = NULL;
+    size_t slots = 2;
+    int r = capacity && capacity <= (size_t)1 << 30 ? 0 : -EINVAL;
+
+    for (; slots < 2 * capacity; slots *= 2) {
+    }
+
+    c = r ? NULL : calloc(1, sizeof(*c));
+    r = r ? r : !c ? -ENOMEM : 0;
+
+    if (c) {
+        c->capacity = capacity;
+        c->mask = slots - 1;
+        c->entries = malloc(capacity * sizeof(*c->entries));
+        c->slots = calloc(slots, sizeof(*c->slots));
+        r = c->entries && c->slots ? 0 : -ENOMEM;
+    }
+
+    *out = r ? (cache_delete(c), NULL) : c;
+    return r;
+}
+
+void cache_delete(struct cache *c)
+{
+    if (c) {
+        free(c->entries);
+        free(c->slots);
+    }
+    free(c);
+}
+
+/// @return FNV-1a hash of @c key.
+static uint64_t hash(const char *key, size_t length)
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+
+    for (size_t i = 0; i < length; ++i) {
+        h = (h ^ (unsigned char)key[i]) * UINT64_C(1099511628211);
+    }
+
+    return h;
+}
+
+/// @return Slot of @c key with @c h, or the empty slot that ends its probe sequence.
+static size_t find(const struct cache *c, uint64_t h, const char *key, size_t key_length)
+{
+    size_t i = h & c->mask;
+
+    for (; c->slots[i]; i = (i + 1) & c->mask) {
+        const struct entry *e = &c->entries[c->slots[i] - 1];
+
+        if (e->hash == h && e->key_length == key_length && !memcmp(e->bytes, key, key_length)) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+const char *cache_get(struct cache *c, const char *key, size_t key_length, size_t *length)
+{
+    size_t i = find(c, hash(key, key_length), key, key_length);
+    struct entry *e = c->slots[i] ? &c->entries[c->slots[i] - 1] : NULL;
+
+    c->metrics.hits += e != NULL;
+    c->metrics.misses += e == NULL;
+
+    if (!e) {
+        return NULL;
+    }
+
+    e->referenced = true;
+    *length = e->length;
+    return e->bytes + e->key_length;
+}
+
+/// Remove slot @c i from the index, moving later slots of its probe sequence back, so that no lookup stops early.
+static void unlink_slot(struct cache *c, size_t i)
+{
+    for (size_t j = (i + 1) & c->mask; c->slots[j]; j = (j + 1) & c->mask) {
+        size_t home = c->entries[c->slots[j] - 1].hash & c->mask;
+
+        // The entry at j may move to i unless its home slot is cyclically in (i, j].
+        if (((j - home) & c->mask) >= ((j - i) & c->mask)) {
+            c->slots[i] = c->slots[j];
+            i = j;
+        }
+    }
+
+    c->slots[i] = 0;
+}
+
+/// Evict an entry, sparing those referenced since the hand last passed.
+/// @return Number of the entry evicted.
+static size_t evict(struct cache *c)
+{
+    size_t victim;
+
+    while (c->entries[c->hand].referenced) {
+        c->entries[c->hand].referenced = false;
+        c->hand = (c->hand + 1) % c->capacity;
+    }
+
+    victim = c->hand;
+    c->hand = (c->hand + 1) % c->capacity;
+
+    // Find the slot of the victim by its hash.
+    size_t i = c->entries[victim].hash & c->mask;
+    for (; c->slots[i] != victim + 1; i = (i + 1) & c->mask) {
+    }
+
+    unlink_slot(c, i);
+    c->metrics.evictions++;
+    return victim;
+}
+
+bool cache_put(struct cache *c, const char *key, size_t key_length, const char *value, size_t length)
+{
+    uint64_t h = hash(key, key_length);
+    size_t n;
+
+    if (key_length + length > CACHE_ENTRY_MAX) {
+        return false;
+    }
+
+    n = c->count < c->capacity ? c->count++ : evict(c);
+    c->entries[n].hash = h;
+    c->entries[n].key_length = (uint16_t)key_length;
+    c->entries[n].length = (uint16_t)length;
+    c->entries[n].referenced = false;
+    memcpy(c->entries[n].bytes, key, key_length);
+    memcpy(c->entries[n].bytes + key_length, value, length);
+
+    // The key is not cached, so its probe sequence ends at an empty slot.
+    c->slots[find(c, h, key, key_length)] = (uint32_t)(n + 1);
+    return true;
+}
+
+void cache_clear(struct cache *c)
+{
+    memset(c->slots, 0, (c->mask + 1) * sizeof(*c->slots));
+    c->count = 0;
+    c->hand = 0;
+}
+
+void cache_metrics(const struct cache *c, struct cache_metrics *metrics)
+{
+    *metrics = c->metrics;
+    metrics->entries = c->count;
+}
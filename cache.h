@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Greatest length of a key and its value together.
+#define CACHE_ENTRY_MAX 240
+
+/// Bounded map from byte strings to byte strings, for use by one thread.
+/// When full, an entry is evicted by CLOCK: entries are visited in a circle, and one that has been found since it was
+/// last visited is spared once, so that entries found often stay cached.
+struct cache;
+
+/// Counters of a cache.
+struct cache_metrics {
+    /// Number of keys found, and not found.
+    uint64_t hits;
+    uint64_t misses;
+    /// Number of entries evicted to make room for others.
+    uint64_t evictions;
+    /// Number of entries.
+    size_t entries;
+};
+
+/// Make a cache of at most @c capacity entries.
+/// @return Zero on success, negative otherwise.
+/// @return -EINVAL If @c capacity is zero or exceeds 2^30.
+/// @return -ENOMEM If memory is exhausted.
+int cache_new(size_t capacity, struct cache **out);
+
+void cache_delete(struct cache *c);
+
+/// Find the value of @c key of @c key_length bytes.
+/// @return Value, with its length in @c length, or NULL if @c key is not cached.
+/// The value is valid until the next call of cache_put or cache_clear.
+const char *cache_get(struct cache *c, const char *key, size_t key_length, size_t *length);
+
+/// Cache @c value of @c length bytes for @c key of @c key_length bytes, which is not cached, evicting an entry if
+/// the cache is full.
+/// @return True if cached; false if the key and value together exceed CACHE_ENTRY_MAX bytes.
+bool cache_put(struct cache *c, const char *key, size_t key_length, const char *value, size_t length);
+
+/// Remove every entry, keeping the counters.
+void cache_clear(struct cache *c);
+
+/// Get @c metrics of @c c.
+void cache_metrics(const struct cache *c, struct cache_metrics *metrics);
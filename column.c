@@ -0,0 +1,138 @@
+#include "column.h"
+#include "label.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+/// Number of values in a block; a block of input and of output fit in a typical level 1 data cache.
+#define BLOCK 2048
+
+/// Maximum number of threads.
+#define THREAD_MAX 64
+
+/// Vector of doubles.
+typedef double vector __attribute__((vector_size(4 * sizeof(double))));
+
+/// Vector of lane masks.
+typedef int64_t mask __attribute__((vector_size(4 * sizeof(double))));
+
+/// Number of lanes in a vector.
+#define LANES (sizeof(vector) / sizeof(double))
+
+/// Conversion of a range of blocks.
+struct task {
+    /// Column.
+    const struct column *column;
+    /// Destination.
+    double *out;
+    /// Fused multiplier and addend.
+    vector multiplier;
+    vector addend;
+    /// Range of values.
+    size_t first;
+    size_t last;
+    /// Thread.
+    pthread_t thread;
+};
+
+int column_unit(const wchar_t *label, enum unit *unit)
+{
+    wchar_t *p;
+
+    *unit = label_lookup((wchar_t *)label, &p);
+    return (*p || !symbol_of_unit(*unit)) ? -EINVAL : 0;
+}
+
+/// @return Lane mask of value @c i, all ones if valid.
+static int64_t lane(const uint8_t *validity, size_t i)
+{
+    return validity ? -(int64_t)((validity[i >> 3] >> (i & 7)) & 1) : -1;
+}
+
+/// Convert @c n values at @c i, at least one and at most one vector, selecting converted or original values by validity.
+static void convert(const struct task *task, size_t i, size_t n)
+{
+    const uint8_t *validity = task->column->validity;
+    // Lanes beyond @c n repeat the validity of value @c i, so as not to read beyond the bitmap.
+    mask valid = {
+        lane(validity, i), lane(validity, i + 1 * (1 < n)), lane(validity, i + 2 * (2 < n)), lane(validity, i + 3 * (3 < n))
+    };
+    vector x = { 0 };
+    vector y;
+
+    memcpy(&x, task->column->values + i, n * sizeof(double));
+    y = x * task->multiplier + task->addend;
+    y = (vector)(((mask)y & valid) | ((mask)x & ~valid));
+    memcpy(task->out + i, &y, n * sizeof(double));
+}
+
+/// Convert range of @c task, block by block.
+static void *run(void *arg)
+{
+    const struct task *task = arg;
+
+    for (size_t block = task->first; block < task->last; block += BLOCK) {
+        size_t end = block + BLOCK < task->last ? block + BLOCK : task->last;
+        size_t i = block;
+
+        for (; i + LANES <= end; i += LANES) {
+            convert(task, i, LANES);
+        }
+
+        if (i < end) {
+            convert(task, i, end - i);
+        }
+    }
+
+    return NULL;
+}
+
+int column_convert(const struct column *column, enum unit to, double *out, unsigned threads)
+{
+    struct unit_conversion c;
+    size_t blocks = (column->length + BLOCK - 1) / BLOCK;
+    size_t n;
+    size_t started;
+    int r;
+
+    r = unit_conversion(column->unit, to, &c);
+    if (r) {
+        return r;
+    }
+
+    // One thread per block at most.
+    n = threads ? threads : (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+    n = n < blocks ? n : blocks;
+    n = n < THREAD_MAX ? n : THREAD_MAX;
+    n = n ? n : 1;
+
+    struct task tasks[n];
+
+    for (size_t t = 0; t < n; ++t) {
+        tasks[t] = (struct task){
+            .column = column,
+            .out = out,
+            .multiplier = { c.multiplier, c.multiplier, c.multiplier, c.multiplier },
+            .addend = { c.addend, c.addend, c.addend, c.addend },
+            .first = blocks * t / n * BLOCK,
+            .last = t + 1 < n ? blocks * (t + 1) / n * BLOCK : column->length,
+        };
+    }
+
+    // The last range is converted by this thread, with any others for which a thread could not be started.
+    for (started = 0; started + 1 < n && !pthread_create(&tasks[started].thread, NULL, run, &tasks[started]); ++started) {
+    }
+
+    for (size_t t = started; t < n; ++t) {
+        run(&tasks[t]);
+    }
+
+    for (size_t t = 0; t < started; ++t) {
+        pthread_join(tasks[t].thread, NULL);
+    }
+
+    return 0;
+}
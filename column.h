@@ -0,0 +1,34 @@
+#pragma once
+
+#include "unit.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+
+/// Column of double precision values, laid out as an Arrow or Parquet buffer.
+struct column {
+    /// Values.
+    const double *values;
+    /// Validity bitmap, least significant bit first; value i is null if bit i is clear.
+    /// NULL if all values are valid.
+    const uint8_t *validity;
+    /// Number of values.
+    size_t length;
+    /// Unit of values.
+    enum unit unit;
+};
+
+/// Resolve the unit of a column from its @c label.
+/// @return Zero on success, negative otherwise.
+/// @return -EINVAL If @c label is not a unit label in its entirety.
+int column_unit(const wchar_t *label, enum unit *unit);
+
+/// Convert the values of @c column to unit @c to.
+/// Values are converted with the fused multiplier and addend of unit_conversion, in blocks shared between threads.
+/// Null values are copied unchanged, so the validity bitmap of @c column also describes @c out.
+/// @param out Updated with @c column->length values; may be @c column->values.
+/// @param threads Number of threads, or zero for one per online processor.
+/// @return Zero on success, negative otherwise.
+/// @return -EPERM If the unit of @c column cannot be converted to @c to.
+int column_convert(const struct column *column, enum unit to, double *out, unsigned threads);
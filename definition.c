@@ -0,0 +1,606 @@
+#include "definition.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wchar.h>
+
+#ifdef __APPLE__
+#define st_mtim st_mtimespec
+#endif
+
+/// Cache file identification, including format version.
+static const char Magic[8] = "unico\0\0\2";
+
+/// Cache file header, followed by the tables.
+struct header {
+    /// Magic number.
+    char magic[8];
+    /// Size of wchar_t.
+    uint32_t wchar_size;
+    /// Number of built-in base units, with which defined base units are numbered.
+    uint32_t builtin_bases;
+    /// Number of built-in units, with which defined units are numbered.
+    uint32_t builtin_units;
+    /// Table sizes.
+    uint32_t bases;
+    uint32_t units;
+    uint32_t labels;
+    uint32_t nodes;
+    uint32_t strings;
+    /// Size of source file.
+    uint64_t source_size;
+    /// Modification time of source file.
+    int64_t source_sec;
+    int64_t source_nsec;
+};
+
+/// Byte offsets of tables within an image.
+struct layout {
+    size_t scale;
+    size_t offset;
+    size_t symbol;
+    size_t base;
+    size_t replaces;
+    size_t base_symbol;
+    size_t replacement;
+    size_t label;
+    size_t node;
+    size_t strings;
+    /// Size of image.
+    size_t size;
+};
+
+struct definitions {
+    /// Tables, referring to @c image.
+    struct extension ext;
+    /// Image of cache file.
+    void *image;
+    /// Size of image.
+    size_t size;
+    /// True if image is mapped, false if allocated.
+    bool mapped;
+};
+
+/// Built-in base units.
+static const struct {
+    const wchar_t *symbol;
+    enum base base;
+} builtin_bases[] = {
+#define b(symbol, name) { symbol, name },
+#include "unit.hi"
+};
+
+/// @return @c n rounded up to a multiple of eight.
+static size_t align8(size_t n)
+{
+    return (n + 7) & ~(size_t)7;
+}
+
+/// @return Layout of image with table sizes given by @c h.
+static struct layout layout_of(const struct header *h)
+{
+    struct layout l;
+
+    l.scale = align8(sizeof(*h));
+    l.offset = l.scale + h->units * sizeof(double);
+    l.symbol = l.offset + h->units * sizeof(double);
+    l.base = l.symbol + h->units * sizeof(uint32_t);
+    l.replaces = l.base + h->units * sizeof(int32_t);
+    l.base_symbol = l.replaces + h->units * sizeof(int32_t);
+    l.replacement = l.base_symbol + h->bases * sizeof(uint32_t);
+    l.label = align8(l.replacement + h->builtin_units * sizeof(uint32_t));
+    l.node = l.label + h->labels * sizeof(struct extension_label);
+    l.strings = l.node + h->nodes * sizeof(struct extension_node);
+    l.size = l.strings + h->strings * sizeof(wchar_t);
+    return l;
+}
+
+/// Working state used to build an image.
+struct builder {
+    /// Table sizes.
+    struct header h;
+    /// Writable tables, sized for the worst case.
+    double *scale;
+    double *offset;
+    uint32_t *symbol;
+    int32_t *base;
+    int32_t *replaces;
+    uint32_t *base_symbol;
+    uint32_t *replacement;
+    struct extension_label *label;
+    struct extension_node *node;
+    wchar_t *strings;
+};
+
+/// Point tables of @c ext into @c image, which has table sizes given by its header.
+static void bind(struct extension *ext, const void *image)
+{
+    const struct header *h = image;
+    const char *p = image;
+    struct layout l = layout_of(h);
+
+    ext->bases = h->bases;
+    ext->units = h->units;
+    ext->labels = h->labels;
+    ext->nodes = h->nodes;
+    ext->scale = (const double *)(p + l.scale);
+    ext->offset = (const double *)(p + l.offset);
+    ext->symbol = (const uint32_t *)(p + l.symbol);
+    ext->base = (const int32_t *)(p + l.base);
+    ext->replaces = (const int32_t *)(p + l.replaces);
+    ext->replacement = (const uint32_t *)(p + l.replacement);
+    ext->label = (const struct extension_label *)(p + l.label);
+    ext->node = (const struct extension_node *)(p + l.node);
+    ext->strings = (const wchar_t *)(p + l.strings);
+}
+
+/// @return Offset of copy of string @c s in string table.
+static uint32_t intern(struct builder *b, const wchar_t *s)
+{
+    uint32_t offset = b->h.strings;
+
+    wcscpy(b->strings + offset, s);
+    b->h.strings += wcslen(s) + 1;
+    return offset;
+}
+
+/// @return Defined or built-in base unit with @c symbol, or BaseUnitNone.
+static enum base find_base(const struct builder *b, const wchar_t *symbol)
+{
+    for (size_t i = 0; i < sizeof(builtin_bases) / sizeof(*builtin_bases); ++i) {
+        if (!wcscmp(builtin_bases[i].symbol, symbol)) {
+            return builtin_bases[i].base;
+        }
+    }
+
+    for (uint32_t i = 0; i < b->h.bases; ++i) {
+        if (!wcscmp(b->strings + b->base_symbol[i], symbol)) {
+            return (enum base)(BaseUnitCount + i);
+        }
+    }
+
+    return BaseUnitNone;
+}
+
+/// @return Defined or built-in unit with @c symbol, or PresentationUnitNone.
+static enum unit find_unit(const struct builder *b, const wchar_t *symbol)
+{
+    for (int u = PresentationUnitUnknown + 1; u < PresentationUnitCount; ++u) {
+        if (!wcscmp(symbol_of_unit((enum unit)u), symbol)) {
+            return (enum unit)u;
+        }
+    }
+
+    for (uint32_t i = 0; i < b->h.units; ++i) {
+        if (!wcscmp(b->strings + b->symbol[i], symbol)) {
+            return (enum unit)(PresentationUnitCount + i);
+        }
+    }
+
+    return PresentationUnitNone;
+}
+
+/// Add label, the string at @c text, for @c unit.
+static void add_label(struct builder *b, uint32_t text, enum unit unit)
+{
+    uint32_t n = 0;
+
+    b->label[b->h.labels++] = (struct extension_label){ text, unit };
+
+    for (const wchar_t *s = b->strings + text; *s; ++s) {
+        uint32_t *link = &b->node[n].child;
+
+        while (*link && b->node[*link].ch != (int32_t)*s) {
+            link = &b->node[*link].sibling;
+        }
+
+        if (!*link) {
+            *link = b->h.nodes++;
+            b->node[*link] = (struct extension_node){ *s, 0, 0, PresentationUnitNone };
+        }
+
+        n = *link;
+    }
+
+    b->node[n].unit = unit;
+}
+
+/// @return True if @c field is a finite number, stored in @c value.
+static bool number(const wchar_t *field, double *value)
+{
+    wchar_t *end;
+
+    *value = wcstod(field, &end);
+    return *field && !*end && isfinite(*value);
+}
+
+/// Add definition described by @c n fields.
+/// @return Zero on success, -EINVAL otherwise.
+static int define(struct builder *b, wchar_t **field, size_t n)
+{
+    if (n == 2 && !wcscmp(field[0], L"base")) {
+        if (!*field[1] || find_base(b, field[1])) {
+            return -EINVAL;
+        }
+
+        b->base_symbol[b->h.bases++] = intern(b, field[1]);
+        return 0;
+    }
+
+    if ((n == 4 || n == 5) && !wcscmp(field[0], L"unit")) {
+        enum base base = find_base(b, field[2]);
+        enum unit unit = find_unit(b, field[1]);
+        enum base replaced = BaseUnitNone;
+        double scale;
+        double offset = 0;
+
+        // A unit with the symbol of a built-in unit replaces it, once, keeping its base.
+        if (unit && (size_t)unit < PresentationUnitCount && !b->replacement[unit]) {
+            unit_to_base(0, unit, &replaced);
+        }
+
+        if (!*field[1] || !base || (unit && replaced != base) || !number(field[3], &scale) || scale == 0
+            || (n == 5 && !number(field[4], &offset))) {
+            return -EINVAL;
+        }
+
+        b->scale[b->h.units] = scale;
+        b->offset[b->h.units] = offset;
+        b->symbol[b->h.units] = intern(b, field[1]);
+        b->base[b->h.units] = base;
+        b->replaces[b->h.units] = unit;
+
+        if (unit) {
+            // Labels of the built-in unit, including its symbol, now refer to the replacement.
+            b->replacement[unit] = b->h.units + 1;
+        } else {
+            add_label(b, b->symbol[b->h.units], (enum unit)(PresentationUnitCount + b->h.units));
+        }
+
+        b->h.units++;
+        return 0;
+    }
+
+    if (n == 3 && !wcscmp(field[0], L"label")) {
+        enum unit unit = find_unit(b, field[2]);
+
+        if (!unit || !*field[1]) {
+            return -EINVAL;
+        }
+
+        add_label(b, intern(b, field[1]), unit);
+        return 0;
+    }
+
+    return -EINVAL;
+}
+
+/// Parse definitions in @c text into @c b.
+/// @return Zero on success, -EINVAL otherwise, with @c line updated.
+static int parse(struct builder *b, wchar_t *text, size_t *line)
+{
+    wchar_t *next;
+
+    for (*line = 1; text; text = next, ++*line) {
+        wchar_t *field[6];
+        size_t n = 0;
+
+        next = wcschr(text, L'\n');
+        if (next) {
+            *next++ = L'\0';
+        }
+
+        if (!*text || *text == L'#') {
+            continue;
+        }
+
+        // Split fields at TAB.
+        for (wchar_t *p = text; p && n < sizeof(field) / sizeof(*field); ++n) {
+            field[n] = p;
+            p = wcschr(p, L'\t');
+            if (p) {
+                *p++ = L'\0';
+            }
+        }
+
+        if (define(b, field, n)) {
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/// Build image from text @c wide of @c length characters.
+/// @return Zero on success, negative otherwise, with @c out updated.
+/// @return -EINVAL If definitions are malformed, with @c line updated.
+/// @return -ENOMEM If memory is exhausted.
+static int build(wchar_t *wide, size_t length, const struct stat *st, size_t *line, void **out)
+{
+    struct header bound = { .builtin_units = PresentationUnitCount, .nodes = 1 };
+    struct builder b = { .h = { .builtin_units = PresentationUnitCount, .nodes = 1 } };
+    void *image = NULL;
+    char *scratch;
+    struct layout l;
+    int r;
+
+    // Each line yields at most one base, unit or label, and each character at most one trie node.
+    for (size_t i = 0; i <= length; ++i) {
+        bound.bases += !wide[i] || wide[i] == L'\n';
+    }
+    bound.units = bound.labels = bound.bases;
+    bound.nodes += length;
+    bound.strings = length + bound.bases;
+
+    l = layout_of(&bound);
+    scratch = calloc(1, l.size);
+    r = scratch ? 0 : -ENOMEM;
+    if (scratch) {
+        b.scale = (double *)(scratch + l.scale);
+        b.offset = (double *)(scratch + l.offset);
+        b.symbol = (uint32_t *)(scratch + l.symbol);
+        b.base = (int32_t *)(scratch + l.base);
+        b.replaces = (int32_t *)(scratch + l.replaces);
+        b.base_symbol = (uint32_t *)(scratch + l.base_symbol);
+        b.replacement = (uint32_t *)(scratch + l.replacement);
+        b.label = (struct extension_label *)(scratch + l.label);
+        b.node = (struct extension_node *)(scratch + l.node);
+        b.strings = (wchar_t *)(scratch + l.strings);
+    }
+
+    r = r ? r : parse(&b, wide, line);
+    if (!r) {
+        memcpy(b.h.magic, Magic, sizeof(Magic));
+        b.h.wchar_size = sizeof(wchar_t);
+        b.h.builtin_bases = BaseUnitCount;
+        b.h.source_size = (uint64_t)st->st_size;
+        b.h.source_sec = st->st_mtim.tv_sec;
+        b.h.source_nsec = st->st_mtim.tv_nsec;
+
+        l = layout_of(&b.h);
+        image = calloc(1, l.size);
+        r = image ? 0 : -ENOMEM;
+    }
+
+    if (image) {
+        struct layout from = layout_of(&bound);
+
+        memcpy(image, &b.h, sizeof(b.h));
+        memcpy((char *)image + l.scale, scratch + from.scale, b.h.units * sizeof(double));
+        memcpy((char *)image + l.offset, scratch + from.offset, b.h.units * sizeof(double));
+        memcpy((char *)image + l.symbol, scratch + from.symbol, b.h.units * sizeof(uint32_t));
+        memcpy((char *)image + l.base, scratch + from.base, b.h.units * sizeof(int32_t));
+        memcpy((char *)image + l.replaces, scratch + from.replaces, b.h.units * sizeof(int32_t));
+        memcpy((char *)image + l.base_symbol, scratch + from.base_symbol, b.h.bases * sizeof(uint32_t));
+        memcpy((char *)image + l.replacement, scratch + from.replacement, b.h.builtin_units * sizeof(uint32_t));
+        memcpy((char *)image + l.label, scratch + from.label, b.h.labels * sizeof(struct extension_label));
+        memcpy((char *)image + l.node, scratch + from.node, b.h.nodes * sizeof(struct extension_node));
+        memcpy((char *)image + l.strings, scratch + from.strings, b.h.strings * sizeof(wchar_t));
+    }
+
+    free(scratch);
+    *out = image;
+    return r;
+}
+
+/// @return True if @c unit is a built-in unit or one of the units defined by header @c h.
+static bool valid_unit(const struct header *h, int32_t unit)
+{
+    return unit > PresentationUnitUnknown && unit < (int64_t)PresentationUnitCount + h->units;
+}
+
+/// @return True if every index and offset in the tables of @c image, whose header and size are valid, is in range,
+/// and every string is terminated, so that no lookup reads outside the image or fails to end.
+static bool valid_tables(const void *image)
+{
+    const struct header *h = image;
+    const uint32_t *base_symbol = (const uint32_t *)((const char *)image + layout_of(h).base_symbol);
+    struct extension ext;
+    bool ok;
+
+    bind(&ext, image);
+    ok = ext.nodes && (!h->strings || !ext.strings[h->strings - 1]);
+
+    for (uint32_t i = 0; ok && i < ext.bases; ++i) {
+        ok = base_symbol[i] < h->strings;
+    }
+
+    // A unit and the built-in unit it replaces refer to each other.
+    for (uint32_t i = 0; ok && i < ext.units; ++i) {
+        ok = ext.symbol[i] < h->strings
+            && ext.base[i] > BaseUnitNone && ext.base[i] < (int64_t)BaseUnitCount + ext.bases
+            && isfinite(ext.scale[i]) && ext.scale[i] != 0 && isfinite(ext.offset[i])
+            && (ext.replaces[i] == PresentationUnitNone
+                || (valid_unit(h, ext.replaces[i]) && ext.replaces[i] < PresentationUnitCount
+                    && ext.replacement[ext.replaces[i]] == i + 1));
+    }
+
+    for (uint32_t u = 0; ok && u < PresentationUnitCount; ++u) {
+        ok = !ext.replacement[u]
+            || (ext.replacement[u] <= ext.units && ext.replaces[ext.replacement[u] - 1] == (int32_t)u);
+    }
+
+    for (uint32_t i = 0; ok && i < ext.labels; ++i) {
+        ok = ext.label[i].text < h->strings && valid_unit(h, ext.label[i].unit);
+    }
+
+    // Children and siblings follow their node, so that walking the trie ends.
+    for (uint32_t i = 0; ok && i < ext.nodes; ++i) {
+        const struct extension_node *n = &ext.node[i];
+
+        ok = (!n->child || (n->child > i && n->child < ext.nodes))
+            && (!n->sibling || (n->sibling > i && n->sibling < ext.nodes))
+            && (n->unit == PresentationUnitNone || valid_unit(h, n->unit));
+    }
+
+    return ok;
+}
+
+/// @return True if @c image of @c size bytes is a current, well-formed cache of the source file described by @c st.
+static bool valid(const void *image, size_t size, const struct stat *st)
+{
+    const struct header *h = image;
+
+    return size >= sizeof(*h)
+        && !memcmp(h->magic, Magic, sizeof(Magic))
+        && h->wchar_size == sizeof(wchar_t)
+        && h->builtin_bases == BaseUnitCount
+        && h->builtin_units == PresentationUnitCount
+        && h->source_size == (uint64_t)st->st_size
+        && h->source_sec == st->st_mtim.tv_sec
+        && h->source_nsec == st->st_mtim.tv_nsec
+        && layout_of(h).size == size
+        && valid_tables(image);
+}
+
+/// Map cache file at @c path, if it is current.
+/// @return True on success, with @c defs updated.
+static bool map_cache(const char *path, const struct stat *source, struct definitions *defs)
+{
+    struct stat st;
+    void *image = MAP_FAILED;
+    int fd = open(path, O_RDONLY);
+
+    if (fd >= 0 && !fstat(fd, &st) && st.st_size > 0) {
+        image = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    if (image == MAP_FAILED) {
+        return false;
+    }
+
+    if (!valid(image, (size_t)st.st_size, source)) {
+        munmap(image, (size_t)st.st_size);
+        return false;
+    }
+
+    defs->image = image;
+    defs->size = (size_t)st.st_size;
+    defs->mapped = true;
+    return true;
+}
+
+/// Replace cache file at @c path with @c image of @c size bytes, readable by those who may read the definitions @c st.
+/// Failure is not an error, the cache will be rebuilt on next use.
+static void write_cache(const char *path, const struct stat *st, const void *image, size_t size)
+{
+    char tmp[strlen(path) + sizeof(".XXXXXX")];
+    int fd;
+    bool ok;
+
+    snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+
+    fd = mkstemp(tmp);
+    // The temporary file is created private; the cache is not executable, whatever the definitions.
+    ok = fd >= 0 && !fchmod(fd, st->st_mode & 0666) && write(fd, image, size) == (ssize_t)size;
+    ok = fd >= 0 && !close(fd) && ok;
+
+    if (!ok || rename(tmp, path)) {
+        unlink(tmp);
+    }
+}
+
+/// Read text file at @c path and convert to wide string.
+/// @return Zero on success, negative otherwise, with @c wide updated.
+static int read_text(const char *path, const struct stat *st, wchar_t **wide, size_t *length)
+{
+    size_t size = (size_t)st->st_size;
+    char *bytes = malloc(size + 1);
+    FILE *f = fopen(path, "r");
+    int r = 0;
+
+    *wide = malloc((size + 1) * sizeof(wchar_t));
+
+    if (!f || !bytes || !*wide || fread(bytes, 1, size, f) != size) {
+        r = -EIO;
+    } else {
+        bytes[size] = '\0';
+        *length = mbstowcs(*wide, bytes, size + 1);
+        r = *length == (size_t)-1 ? -EILSEQ : 0;
+    }
+
+    if (f) {
+        fclose(f);
+    }
+
+    free(bytes);
+    return r;
+}
+
+int definitions_load(const char *path, struct definitions **out, size_t *line)
+{
+    char cache[strlen(path) + sizeof(".cache")];
+    struct definitions *defs;
+    struct stat st;
+    wchar_t *wide = NULL;
+    size_t length = 0;
+    int r;
+
+    *out = NULL;
+    *line = 0;
+
+    if (stat(path, &st)) {
+        return -errno;
+    }
+
+    snprintf(cache, sizeof(cache), "%s.cache", path);
+
+    defs = calloc(1, sizeof(*defs));
+    if (defs && map_cache(cache, &st, defs)) {
+        bind(&defs->ext, defs->image);
+        *out = defs;
+        return 0;
+    }
+
+    r = defs ? read_text(path, &st, &wide, &length) : -ENOMEM;
+    if (!r) {
+        r = build(wide, length, &st, line, &defs->image);
+    }
+
+    if (!r) {
+        defs->size = layout_of(defs->image).size;
+        write_cache(cache, &st, defs->image, defs->size);
+        bind(&defs->ext, defs->image);
+        *out = defs;
+    } else {
+        free(defs);
+    }
+
+    free(wide);
+    return r;
+}
+
+const struct extension *definitions_extension(const struct definitions *defs)
+{
+    return &defs->ext;
+}
+
+size_t definitions_size(const struct definitions *defs)
+{
+    return sizeof(*defs) + defs->size;
+}
+
+void definitions_delete(struct definitions *defs)
+{
+    if (defs) {
+        if (defs->mapped) {
+            munmap(defs->image, defs->size);
+        } else {
+            free(defs->image);
+        }
+
+        free(defs);
+    }
+}
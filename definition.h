@@ -0,0 +1,38 @@
+#pragma once
+
+#include "extension.h"
+
+#include <stddef.h>
+
+/// Unit definitions loaded at runtime.
+///
+/// A definitions file is text, one definition per line, with fields separated by TAB.
+/// Lines that are empty or begin with '#' are ignored.
+///
+///     base    SYMBOL
+///     unit    SYMBOL  BASE    SCALE   [OFFSET]
+///     label   LABEL   UNIT
+///
+/// BASE refers to the symbol of a built-in or defined base unit.
+/// UNIT refers to the symbol of a built-in or defined unit.
+/// A unit converts to its base unit as base = (X + OFFSET) * SCALE, and its symbol is also a label.
+/// A unit with the symbol of a built-in unit replaces it, and must have its base: labels of the built-in unit then
+/// refer to the replacement. A defined label takes precedence over a built-in label of the same length.
+struct definitions;
+
+/// Load definitions from file @c path.
+/// A binary index is cached in file "<path>.cache" and rebuilt only when @c path changes.
+/// @param line Updated with the number of the line containing a malformed definition.
+/// @return Zero on success, negative otherwise.
+/// @return -EINVAL If a definition is malformed.
+/// @return -EILSEQ If the file is not valid in the current locale.
+int definitions_load(const char *path, struct definitions **out, size_t *line);
+
+/// @return Extension described by @c defs.
+const struct extension *definitions_extension(const struct definitions *defs);
+
+/// @return Size in bytes of the memory held by @c defs.
+size_t definitions_size(const struct definitions *defs);
+
+/// Destructor.
+void definitions_delete(struct definitions *defs);
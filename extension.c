@@ -0,0 +1,133 @@
+#include "extension.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/// Reading state of a thread.
+/// Records are never freed; that of an exited thread is reused by another.
+struct reader {
+    /// Global epoch on entry, or zero if the thread is not reading.
+    _Atomic uint64_t epoch;
+    /// True if owned by a thread.
+    atomic_bool used;
+    /// Next record.
+    struct reader *next;
+    /// Depth of nested sections; owner only.
+    unsigned depth;
+    /// Extension current on entry; owner only.
+    const struct extension *pinned;
+};
+
+/// Current extension.
+static _Atomic(const struct extension *) current;
+
+/// Global epoch, advanced by extension_synchronize.
+static _Atomic uint64_t epoch = 1;
+
+/// Records of all threads that have read.
+static _Atomic(struct reader *) readers;
+
+/// Record of this thread.
+static _Thread_local struct reader *self;
+
+/// Key whose destructor releases the record of an exiting thread.
+static pthread_key_t key;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+/// A thread may exit inside a section: end it, so that writers do not wait for it and the next owner starts idle.
+static void release(void *record)
+{
+    struct reader *r = record;
+
+    r->depth = 0;
+    r->pinned = NULL;
+    atomic_store(&r->epoch, 0);
+    atomic_store(&r->used, false);
+}
+
+static void create_key(void)
+{
+    pthread_key_create(&key, release);
+}
+
+/// @return Record for this thread, reusing that of an exited thread if possible, or NULL if memory is exhausted.
+static struct reader *acquire(void)
+{
+    struct reader *r;
+
+    for (r = atomic_load(&readers); r; r = r->next) {
+        bool unused = false;
+        if (atomic_compare_exchange_strong(&r->used, &unused, true)) {
+            return r;
+        }
+    }
+
+    r = calloc(1, sizeof(*r));
+    if (r) {
+        atomic_store(&r->used, true);
+        r->next = atomic_load(&readers);
+        while (!atomic_compare_exchange_weak(&readers, &r->next, r)) {
+        }
+    }
+
+    return r;
+}
+
+void extension_set(const struct extension *ext)
+{
+    atomic_store(&current, ext);
+}
+
+const struct extension *extension_get(void)
+{
+    return self && self->depth ? self->pinned : atomic_load_explicit(&current, memory_order_acquire);
+}
+
+int extension_enter(void)
+{
+    if (!self) {
+        pthread_once(&once, create_key);
+        self = acquire();
+        pthread_setspecific(key, self);
+    }
+
+    if (self && self->depth++ == 0) {
+        // Publish the epoch before loading the extension, so that a writer that advances the epoch after replacing
+        // the extension either waits for this thread or is seen to have replaced it.
+        atomic_store(&self->epoch, atomic_load(&epoch));
+        self->pinned = atomic_load(&current);
+    }
+
+    return self ? 0 : -ENOMEM;
+}
+
+void extension_leave(void)
+{
+    // A thread that is not reading, or whose extension_enter failed, has nothing to end.
+    if (self && self->depth && --self->depth == 0) {
+        self->pinned = NULL;
+        atomic_store(&self->epoch, 0);
+    }
+}
+
+uint64_t extension_epoch(void)
+{
+    return self ? atomic_load_explicit(&self->epoch, memory_order_relaxed) : 0;
+}
+
+void extension_synchronize(void)
+{
+    uint64_t target = atomic_fetch_add(&epoch, 1) + 1;
+
+    for (struct reader *r = atomic_load(&readers); r; r = r->next) {
+        uint64_t e;
+        while ((e = atomic_load(&r->epoch)) && e < target) {
+            sched_yield();
+        }
+    }
+}
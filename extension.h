@@ -0,0 +1,94 @@
+#pragma once
+
+#include "unit.h"
+
+#include <stdint.h>
+
+/// Label defined at runtime.
+struct extension_label {
+    /// Offset of label in @c strings.
+    uint32_t text;
+    /// Unit.
+    int32_t unit;
+};
+
+/// Node of label trie.
+struct extension_node {
+    /// Character.
+    int32_t ch;
+    /// Index of first child, or zero if none.
+    uint32_t child;
+    /// Index of next sibling, or zero if none.
+    uint32_t sibling;
+    /// Unit if a label ends at this node, otherwise PresentationUnitNone.
+    int32_t unit;
+};
+
+/// Units and labels defined at runtime, described by struct-of-arrays tables.
+/// The tables may refer directly to a read-only mapping of a binary cache file.
+struct extension {
+    /// Number of base units, numbered from BaseUnitCount.
+    uint32_t bases;
+    /// Number of units, numbered from PresentationUnitCount.
+    uint32_t units;
+    /// Number of labels.
+    uint32_t labels;
+    /// Number of trie nodes; node zero is the root.
+    uint32_t nodes;
+    /// Offset of unit symbol in @c strings.
+    const uint32_t *symbol;
+    /// Base of unit.
+    const int32_t *base;
+    /// Multiplier from unit to base unit.
+    const double *scale;
+    /// Offset added to quantity before scaling to base unit.
+    const double *offset;
+    /// Built-in unit replaced by unit, or PresentationUnitNone. May be NULL if none is replaced.
+    const int32_t *replaces;
+    /// For each built-in unit, one plus the index of the unit that replaces it, or zero. May be NULL.
+    /// A replaced built-in unit converts as its replacement.
+    const uint32_t *replacement;
+    /// Labels.
+    const struct extension_label *label;
+    /// Label trie.
+    const struct extension_node *node;
+    /// NUL-terminated strings.
+    const wchar_t *strings;
+};
+
+// Thread safety.
+//
+// Built-in unit and label tables are immutable, and mutable state such as the parser belongs to one thread.
+// The current extension is published through an atomic pointer and reclaimed with epochs, so readers never lock:
+// a thread that may run while another replaces the extension brackets its use of units and labels with
+// extension_enter and extension_leave, and the thread that replaces the extension calls extension_synchronize
+// before it releases the previous one.
+
+/// Install @c ext as the current extension.
+/// Threads reading the previous extension may continue to do so until extension_synchronize returns.
+/// @param ext May be NULL to remove the current extension.
+void extension_set(const struct extension *ext);
+
+/// @return Current extension, or NULL.
+/// Between extension_enter and extension_leave, the extension current on entry.
+const struct extension *extension_get(void);
+
+/// Begin reading the current extension in the calling thread, which continues to see it until extension_leave,
+/// even if it is replaced. Sections may be nested. Does not lock.
+/// @return Zero on success, negative otherwise, in which case extension_leave must not be called.
+/// @return -ENOMEM If memory is exhausted on the first call in a thread.
+int extension_enter(void);
+
+/// End reading the extension, as begun by extension_enter.
+/// Does nothing if the calling thread is not reading.
+void extension_leave(void);
+
+/// @return Epoch on entry to the section of the calling thread, begun by extension_enter, or zero if the thread is
+/// not reading.
+/// The epoch advances with each extension_synchronize, before a replaced extension may be released, so with
+/// extension_get it identifies the extension read, even if a later extension reuses its address.
+uint64_t extension_epoch(void);
+
+/// Wait until no thread reads an extension that was replaced before this call, so that it may be released.
+/// @note Must not be called between extension_enter and extension_leave, since it would wait for the caller.
+void extension_synchronize(void);
@@ -0,0 +1,391 @@
+#include "extract.h"
+#include "extension.h"
+#include "label.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Labels are matched by a trie of their UTF-8 bytes, which is the goto function of an Aho-Corasick automaton.
+// Matching is anchored at the end of a number, so failure transitions are never taken, and text between quantities
+// is skipped by searching for digits alone.
+
+/// Node of label trie.
+struct node {
+    /// Index of first child, or zero if none.
+    uint32_t child;
+    /// Index of next sibling, or zero if none.
+    uint32_t sibling;
+    /// Byte.
+    uint8_t byte;
+    /// Unit if a label ends at this node, otherwise PresentationUnitNone.
+    enum unit unit;
+};
+
+struct extractor {
+    /// Child of the root by byte, or zero if none.
+    uint32_t root[256];
+    /// Nodes; node zero is the root.
+    struct node *nodes;
+    /// Number of nodes.
+    size_t count;
+    /// Capacity of @c nodes.
+    size_t capacity;
+};
+
+/// Encode @c c as UTF-8 in @c out.
+/// @return Number of bytes.
+static size_t utf8(wchar_t c, uint8_t *out)
+{
+    uint32_t u = (uint32_t)c;
+
+    if (u < 0x80) {
+        out[0] = (uint8_t)u;
+        return 1;
+    }
+
+    if (u < 0x800) {
+        out[0] = (uint8_t)(0xc0 | u >> 6);
+        out[1] = (uint8_t)(0x80 | (u & 0x3f));
+        return 2;
+    }
+
+    if (u < 0x10000) {
+        out[0] = (uint8_t)(0xe0 | u >> 12);
+        out[1] = (uint8_t)(0x80 | (u >> 6 & 0x3f));
+        out[2] = (uint8_t)(0x80 | (u & 0x3f));
+        return 3;
+    }
+
+    out[0] = (uint8_t)(0xf0 | u >> 18);
+    out[1] = (uint8_t)(0x80 | (u >> 12 & 0x3f));
+    out[2] = (uint8_t)(0x80 | (u >> 6 & 0x3f));
+    out[3] = (uint8_t)(0x80 | (u & 0x3f));
+    return 4;
+}
+
+/// @return Child of node @c n for @c byte, or zero if none.
+static uint32_t child_of(const struct extractor *x, uint32_t n, uint8_t byte)
+{
+    uint32_t child = n ? x->nodes[n].child : x->root[byte];
+
+    while (child && x->nodes[child].byte != byte) {
+        child = x->nodes[child].sibling;
+    }
+
+    return child;
+}
+
+/// Add child of node @c n for @c byte, which it does not have.
+/// @return Child, or zero if memory is exhausted.
+static uint32_t add_child(struct extractor *x, uint32_t n, uint8_t byte)
+{
+    size_t capacity = x->count < x->capacity ? x->capacity : 2 * x->capacity + 64;
+    struct node *nodes = capacity == x->capacity ? x->nodes : realloc(x->nodes, capacity * sizeof(*nodes));
+    uint32_t child = 0;
+
+    if (nodes) {
+        uint32_t *first = n ? &nodes[n].child : &x->root[byte];
+
+        child = (uint32_t)x->count++;
+        nodes[child] = (struct node){ 0, n ? *first : 0, byte, PresentationUnitNone };
+        *first = child;
+        x->nodes = nodes;
+        x->capacity = capacity;
+    }
+
+    return child;
+}
+
+/// Add @c label of @c unit, unless an earlier label is the same.
+/// @return Zero on success, negative otherwise.
+/// @return -ENOMEM If memory is exhausted.
+static int add_label(struct extractor *x, const wchar_t *label, enum unit unit)
+{
+    uint32_t n = 0;
+
+    for (; *label && n != UINT32_MAX; ++label) {
+        uint8_t bytes[4];
+        size_t length = utf8(*label, bytes);
+
+        for (size_t i = 0; i < length && n != UINT32_MAX; ++i) {
+            uint32_t child = child_of(x, n, bytes[i]);
+            child = child ? child : add_child(x, n, bytes[i]);
+            n = child ? child : UINT32_MAX;
+        }
+    }
+
+    if (n != UINT32_MAX && x->nodes[n].unit == PresentationUnitNone) {
+        x->nodes[n].unit = unit;
+    }
+
+    return n == UINT32_MAX ? -ENOMEM : 0;
+}
+
+struct extractor *extractor_new(void)
+{
+    struct extractor *x = calloc(1, sizeof(*x));
+    const struct extension *ext = extension_get();
+    const wchar_t *label;
+    enum unit unit;
+    // Node zero is the root.
+    int r = x && add_child(x, 0, 0) == 0 ? 0 : -ENOMEM;
+
+    // Defined labels come first, so that they take precedence.
+    for (size_t i = 0; !r && ext && i < ext->labels; ++i) {
+        r = add_label(x, ext->strings + ext->label[i].text, (enum unit)ext->label[i].unit);
+    }
+
+    for (size_t i = 0; !r && (label = label_builtin(i, &unit)); ++i) {
+        r = add_label(x, label, unit);
+    }
+
+    return r ? (extractor_delete(x), NULL) : x;
+}
+
+void extractor_delete(struct extractor *x)
+{
+    if (x) {
+        free(x->nodes);
+    }
+    free(x);
+}
+
+/// @return True if @c c is an ASCII digit.
+static bool is_digit(uint8_t c)
+{
+    return (uint8_t)(c - '0') < 10;
+}
+
+/// @return True if @c c may be part of a word: an ASCII letter, digit or underscore, or part of a character outside
+/// ASCII.
+static bool is_word(uint8_t c)
+{
+    return is_digit(c) || (uint8_t)((c | 0x20) - 'a') < 26 || c == '_' || c >= 0x80;
+}
+
+/// Powers of ten that are exactly representable.
+static const double powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/// @return True if a group of three digits, not followed by another digit, is at @c text[i].
+static bool group(const uint8_t *text, size_t size, size_t i)
+{
+    return i + 3 <= size && is_digit(text[i]) && is_digit(text[i + 1]) && is_digit(text[i + 2])
+        && (i + 3 == size || !is_digit(text[i + 3]));
+}
+
+/// Parse unsigned decimal number, with optional fraction and exponent, at @c text[*i], independent of locale.
+/// Thousands may be grouped by commas, as in "1,200".
+/// @return Number, with @c *i advanced past it.
+static double number(const uint8_t *text, size_t size, size_t *i)
+{
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    size_t j = *i;
+    // Digits of the integer part since its start or its last comma.
+    size_t run = 0;
+
+    for (bool fraction = false; j < size; ++j) {
+        if (text[j] == '.' && !fraction && j + 1 < size && is_digit(text[j + 1])) {
+            fraction = true;
+            continue;
+        }
+
+        // Groups after the first have three digits, as each comma is followed by three.
+        if (text[j] == ',' && !fraction && run && run <= 3 && group(text, size, j + 1)) {
+            run = 0;
+            continue;
+        }
+
+        if (!is_digit(text[j])) {
+            break;
+        }
+
+        run += !fraction;
+        if (digits < 19) {
+            // Digits beyond the precision of the mantissa are counted in the exponent.
+            mantissa = mantissa * 10 + (uint64_t)(text[j] - '0');
+            digits += mantissa > 0;
+            exponent -= fraction;
+        } else {
+            exponent += !fraction;
+        }
+    }
+
+    // Exponent, only if digits follow.
+    size_t k = j + 1 + (j + 1 < size && (text[j + 1] == '+' || text[j + 1] == '-'));
+    if (j < size && (text[j] | 0x20) == 'e' && k < size && is_digit(text[k])) {
+        int e = 0;
+
+        for (; k < size && is_digit(text[k]); ++k) {
+            e = e < 10000 ? e * 10 + (text[k] - '0') : e;
+        }
+
+        exponent += text[j + 1] == '-' ? -e : e;
+        j = k;
+    }
+
+    *i = j;
+
+    // Exact if the mantissa and power of ten are, since the result is then rounded once.
+    if (mantissa < (UINT64_C(1) << 53) && exponent >= -22 && exponent <= 22) {
+        return exponent < 0 ? (double)mantissa / powers[-exponent] : (double)mantissa * powers[exponent];
+    }
+
+    return (double)mantissa * pow(10, exponent);
+}
+
+/// @return Offset of the first byte at or after @c i that is not a space, tab or no-break space.
+static size_t space(const uint8_t *text, size_t size, size_t i)
+{
+    for (;;) {
+        if (i < size && (text[i] == ' ' || text[i] == '\t')) {
+            ++i;
+        } else if (i + 1 < size && text[i] == 0xc2 && text[i + 1] == 0xa0) {
+            i += 2;
+        } else {
+            return i;
+        }
+    }
+}
+
+/// Labels that are also common words, or suffixes of ordinals such as "21st".
+static const char *const words[] = { "in", "st", "t", "stone" };
+
+/// @return True if the label @c text[begin, end) is a common word that is followed by another word, as in
+/// "5 in 10", so that it is not taken as a unit.
+static bool common_word(const uint8_t *text, size_t size, size_t begin, size_t end)
+{
+    size_t next = space(text, size, end);
+    bool followed = next < size && is_word(text[next]);
+
+    for (size_t i = 0; followed && i < sizeof(words) / sizeof(*words); ++i) {
+        if (strlen(words[i]) == end - begin && !memcmp(text + begin, words[i], end - begin)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// @return Offset after the sign of a tolerance, "±" or "+/-", at @c text[i], or @c i if there is none.
+static size_t plus_minus(const uint8_t *text, size_t size, size_t i)
+{
+    return i + 1 < size && text[i] == 0xc2 && text[i + 1] == 0xb1 ? i + 2
+        : i + 2 < size && !memcmp(text + i, "+/-", 3) ? i + 3
+        : i;
+}
+
+/// Match the longest label at @c text[i] that ends at a word boundary.
+/// @return Offset of the end of the label, with its unit in @c unit; PresentationUnitNone if none matches.
+static size_t label(const struct extractor *x, const uint8_t *text, size_t size, size_t i, enum unit *unit)
+{
+    size_t end = i;
+
+    *unit = PresentationUnitNone;
+
+    for (uint32_t n = 0; i < size && (n = child_of(x, n, text[i])) != 0;) {
+        ++i;
+
+        // A label that ends with a letter or digit must not be followed by one, so "m" does not match "miles".
+        if (x->nodes[n].unit != PresentationUnitNone
+            && (text[i - 1] >= 0x80 || !is_word(text[i - 1]) || i == size || !is_word(text[i]))) {
+            *unit = x->nodes[n].unit;
+            end = i;
+        }
+    }
+
+    return end;
+}
+
+bool extractor_find(const struct extractor *x, const char *s, size_t size, size_t *offset,
+    struct extract_match *match)
+{
+    const uint8_t *text = (const uint8_t *)s;
+
+    for (size_t i = *offset; i < size; ++i) {
+        if (!is_digit(text[i])) {
+            continue;
+        }
+
+        // The number may start with a decimal point, and a sign that does not follow a word, as in "-.5" but not
+        // "5-10".
+        size_t begin = i - (i > 0 && text[i - 1] == '.');
+        begin -= begin > 0 && (text[begin - 1] == '-' || text[begin - 1] == '+')
+            && (begin == 1 || !is_word(text[begin - 2]));
+
+        // A number must not be part of a word, or of another number such as "1.5", "1,000" or "1/2".
+        uint8_t before = begin > 0 ? text[begin - 1] : ' ';
+        if (is_word(before) || before == '.' || before == '/'
+            || (before == ',' && begin > 1 && is_digit(text[begin - 2]))) {
+            continue;
+        }
+
+        size_t j = begin + (text[begin] == '-' || text[begin] == '+');
+        double sign = text[begin] == '-' ? -1 : 1;
+        double value = sign * number(text, size, &j);
+        double tolerance = 0;
+        enum unit first;
+
+        // A tolerance is taken with its number, so that it is not found as a quantity of its own.
+        size_t t = space(text, size, j);
+        size_t k = space(text, size, plus_minus(text, size, t));
+        if (k > t && k < size && is_digit(text[k])) {
+            tolerance = number(text, size, &k);
+            j = k;
+        }
+
+        size_t start = space(text, size, j);
+        size_t end = label(x, text, size, start, &first);
+        size_t first_end = end;
+
+        if (first == PresentationUnitNone || common_word(text, size, start, end)) {
+            i = j - 1;
+            continue;
+        }
+
+        // A compound quantity continues with unsigned quantities of lesser parts; the sign applies to the whole.
+        // Parts have no offset, so their quantities of the base unit are summed.
+        double quantity = unit_to_base(value, first, &match->base);
+        for (enum unit part = first, second; unit_compound(part, PresentationUnitNone); part = second) {
+            size_t k = space(text, size, end);
+            if (k == size || !is_digit(text[k])) {
+                break;
+            }
+
+            double lesser = number(text, size, &k);
+            size_t next = label(x, text, size, space(text, size, k), &second);
+            if (second == PresentationUnitNone || !unit_compound(part, second)) {
+                break;
+            }
+
+            quantity += sign * unit_to_base(lesser, second, &match->base);
+            end = next;
+        }
+
+        // The tolerance of a compound quantity is ambiguous.
+        if (tolerance && end != first_end) {
+            i = end - 1;
+            continue;
+        }
+
+        match->value_tolerance = tolerance;
+        match->tolerance = unit_to_base_tolerance(tolerance, first, &match->base);
+        match->begin = begin;
+        match->end = end;
+        match->unit = first;
+        match->quantity = quantity;
+        base_to_unit(match->quantity, match->base, first, &match->value);
+        *offset = end;
+        return true;
+    }
+
+    *offset = size;
+    return false;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "unit.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// Quantity found in text.
+struct extract_match {
+    /// Offset of the quantity, at its number.
+    size_t begin;
+    /// Offset of the end of its last unit label.
+    size_t end;
+    /// Unit of the first part.
+    enum unit unit;
+    /// Quantity of @c unit, including the lesser parts of a compound quantity.
+    double value;
+    /// Quantity of @c base.
+    double quantity;
+    enum base base;
+    /// Tolerance of @c value, written as "± TOLERANCE" or "+/- TOLERANCE" after its number, or zero.
+    double value_tolerance;
+    /// Tolerance of @c quantity.
+    double tolerance;
+};
+
+/// Automaton that finds quantities in text.
+struct extractor;
+
+/// Make an extractor that matches every built-in label, and the labels of the current extension.
+/// @return Extractor, or NULL if memory is exhausted.
+struct extractor *extractor_new(void);
+
+void extractor_delete(struct extractor *x);
+
+/// Find the first quantity in UTF-8 @c text of @c size bytes at or after offset @c *offset.
+/// A quantity is a decimal number that is not part of a word, followed by optional white space and the longest unit
+/// label that ends at a word boundary. Thousands may be grouped by commas, as in "1,200".
+/// A label that is also a common word, such as "in", is taken as a unit only if no word follows, so that "5 in 10" is
+/// not a quantity; a lesser part of a compound quantity, as in "5 ft 3 in of", may be followed by one.
+/// A compound quantity continues with numbers and labels of lesser parts, such as "5 ft 3 in" or "5'3\"".
+/// A number may be followed by a tolerance, as in "12.5 ± 0.1 mm", in which case the quantity is not compound; a
+/// tolerance that is not followed by a label, or is followed by lesser parts, is skipped with its number.
+/// Labels are matched exactly.
+/// @return True if a quantity is found, with @c match updated and @c *offset advanced past it;
+/// otherwise false, with @c *offset at @c size.
+bool extractor_find(const struct extractor *x, const char *text, size_t size, size_t *offset,
+    struct extract_match *match);
@@ -1,176 +1,30 @@
 #include "label.h"
+#include "extension.h"
+#include "normal.h"
 
 #include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wctype.h>
 
 struct lookup {
-    /// Labels may use American or British English.
-    /// Labels may use plurals.
-    /// Labels may refer to SI or non-SI units in common use.
+    /// Label.
     const wchar_t *label;
+    /// Length of label.
+    size_t length;
     /// Unit.
     enum unit unit;
 };
 
 /// Lookup table used for parsing user description of a unit.
-static struct lookup labels[] = {
-    { L"", PresentationUnitNone },
-
-    // Length.
-    { L"mm", PresentationUnitMillimetre },
-    { L"millimetre", PresentationUnitMillimetre },
-    { L"millimetres", PresentationUnitMillimetre },
-    { L"millimeter", PresentationUnitMillimetre },
-    { L"millimeters", PresentationUnitMillimetre },
-    { L"cm", PresentationUnitCentimetre },
-    { L"centimetre", PresentationUnitCentimetre },
-    { L"centimetres", PresentationUnitCentimetre },
-    { L"centimeter", PresentationUnitCentimetre },
-    { L"centimeters", PresentationUnitCentimetre },
-    { L"m", PresentationUnitMetre },
-    { L"metre", PresentationUnitMetre },
-    { L"metres", PresentationUnitMetre },
-    { L"meter", PresentationUnitMetre },
-    { L"meters", PresentationUnitMetre },
-    { L"km", PresentationUnitKilometre },
-    { L"kilometre", PresentationUnitKilometre },
-    { L"kilometres", PresentationUnitKilometre },
-    { L"kilometer", PresentationUnitKilometre },
-    { L"kilometers", PresentationUnitKilometre },
-    // Non-SI.
-    { L"mi", PresentationUnitMile },
-    { L"mile", PresentationUnitMile },
-    { L"miles", PresentationUnitMile },
-    { L"yd", PresentationUnitYard },
-    { L"yds", PresentationUnitYard },
-    { L"yard", PresentationUnitYard },
-    { L"yards", PresentationUnitYard },
-    { L"'", PresentationUnitFeet },
-    { L"ft", PresentationUnitFeet },
-    { L"feet", PresentationUnitFeet },
-    { L"foot", PresentationUnitFeet },
-    { L"'\"", PresentationUnitFeetAndInches },
-    { L"\"", PresentationUnitInch },
-    { L"in", PresentationUnitInch },
-    { L"inch", PresentationUnitInch },
-    { L"inches", PresentationUnitInch },
-
-    // Area.
-    { L"m^2", PresentationUnitSquareMetre },
-    { L"ha", PresentationUnitHectare },
-    { L"hectare", PresentationUnitHectare },
-    // Non-SI.
-    { L"acre", PresentationUnitAcre },
-    { L"acres", PresentationUnitAcre },
-    { L"ft^2", PresentationUnitSquareFoot },
-    { L"sq ft", PresentationUnitSquareFoot },
-    { L"square foot", PresentationUnitSquareFoot },
-    { L"square feet", PresentationUnitSquareFoot },
-
-    // Volume.
-    { L"m^3", PresentationUnitCubicMetre },
-    { L"cm^3", PresentationUnitCubicCentimetre },
-    { L"L", PresentationUnitLitre },
-    { L"dL", PresentationUnitDecilitre },
-    { L"cL", PresentationUnitCentilitre },
-    { L"mL", PresentationUnitMillilitre },
-    { L"l", PresentationUnitLitreAlt },
-    { L"dl", PresentationUnitDecilitreAlt },
-    { L"cl", PresentationUnitCentilitreAlt },
-    { L"ml", PresentationUnitMillilitreAlt },
-    // Non-SI.
-    { L"cc", PresentationUnitCubicCentimetre },
-    { L"pt", PresentationUnitPint },
-    { L"pint", PresentationUnitPint },
-    { L"US pt", PresentationUnitPintUS },
-    { L"US pint", PresentationUnitPintUS },
-    { L"ft^3", PresentationUnitCubicFoot },
-    { L"cu ft", PresentationUnitCubicFoot },
-    { L"cubic foot", PresentationUnitCubicFoot },
-    { L"cubic feet", PresentationUnitCubicFoot },
-    { L"in^3", PresentationUnitCubicInch },
-    { L"cu in", PresentationUnitCubicInch },
-    { L"cubic inch", PresentationUnitCubicInch },
-
-    // Mass.
-    { L"mg", PresentationUnitMilligram },
-    { L"milligram", PresentationUnitMilligram },
-    { L"milligrams", PresentationUnitMilligram },
-    { L"g", PresentationUnitGram },
-    { L"gram", PresentationUnitGram },
-    { L"grams", PresentationUnitGram },
-    { L"kg", PresentationUnitKilogram },
-    { L"kilogram", PresentationUnitKilogram },
-    { L"kilograms", PresentationUnitKilogram },
-    { L"Mg", PresentationUnitMegagram },
-    { L"megagram", PresentationUnitMegagram },
-    { L"megagrams", PresentationUnitMegagram },
-    // Non-SI.
-    { L"t", PresentationUnitTonne },
-    { L"tonne", PresentationUnitTonne },
-    { L"tonnes", PresentationUnitTonne },
-    { L"tn", PresentationUnitShortTon },
-    { L"short ton", PresentationUnitShortTon },
-    { L"short tons", PresentationUnitShortTon },
-    { L"US ton", PresentationUnitShortTon },
-    { L"US tons", PresentationUnitShortTon },
-    { L"long ton", PresentationUnitLongTon },
-    { L"long tons", PresentationUnitLongTon },
-    { L"imperial ton", PresentationUnitLongTon },
-    { L"imperial tons", PresentationUnitLongTon },
-    { L"lb", PresentationUnitPound },
-    { L"lbs", PresentationUnitPound },
-    { L"pound", PresentationUnitPound },
-    { L"pounds", PresentationUnitPound },
-    { L"oz", PresentationUnitOunce },
-    { L"ounce", PresentationUnitOunce },
-    { L"ounces", PresentationUnitOunce },
-
-    // Thermodynamic temperature.
-    { L"K", PresentationUnitKelvin },
-    { L"kelvin", PresentationUnitKelvin },
-    { L"°C", PresentationUnitDegreesCelsius },
-    { L"'C", PresentationUnitDegreesCelsius },
-    { L"degree Celsius", PresentationUnitDegreesCelsius },
-    { L"degrees Celsius", PresentationUnitDegreesCelsius },
-    // Non-SI.
-    { L"°F", PresentationUnitDegreesFahrenheit },
-    { L"'F", PresentationUnitDegreesFahrenheit },
-    { L"degree Fahrenheit", PresentationUnitDegreesFahrenheit },
-    { L"degrees Fahrenheit", PresentationUnitDegreesFahrenheit },
-
-    // Pressure.
-    { L"Pa", PresentationUnitPascal },
-    { L"pascal", PresentationUnitPascal },
-    { L"hPa", PresentationUnitHectoPascal },
-    { L"hectopascal", PresentationUnitHectoPascal },
-    { L"hectopascals", PresentationUnitHectoPascal },
-    { L"kPa", PresentationUnitKiloPascal },
-    { L"kilopascal", PresentationUnitKiloPascal },
-    { L"kilopascals", PresentationUnitKiloPascal },
-    // Not SI, but used especially in meterology.
-    { L"mbar", PresentationUnitMillibar },
-    { L"millibar", PresentationUnitMillibar },
-    { L"millibars", PresentationUnitMillibar },
-    { L"bar", PresentationUnitBar },
-    // Not SI, but commonly used.
-    { L"psi", PresentationUnitPoundPerSquareInch },
-    // Non-SI.
-    { L"mmHg", PresentationUnitMillimetreMercury },
-    { L"mm Hg", PresentationUnitMillimetreMercury },
-    { L"inHg", PresentationUnitInchesMercury },
-    { L"\"Hg", PresentationUnitInchesMercury },
-
-    // Plane angle.
-    { L"rad", PresentationUnitRadian },
-    { L"radian", PresentationUnitRadian },
-    { L"radians", PresentationUnitRadian },
-    { L"°", PresentationUnitDegree },
-    { L"degree", PresentationUnitDegree },
-    { L"degrees", PresentationUnitDegree },
+static const struct lookup labels[] = {
+    { L"", 0, PresentationUnitNone },
+
+#define l(label, unit) { label, sizeof(label) / sizeof(wchar_t) - 1, unit },
+#include "label.hi"
 };
 
 /// @return True if end of word.
@@ -179,11 +33,11 @@ static bool is_eow(const wchar_t *s)
     return !s || !*s || iswspace(*s) || iswdigit(*s);
 }
 
-/// @return True if string @c s matches, or begins with, string @c w.
-static bool accept_word(wchar_t *s, const wchar_t *w, wchar_t **p)
+/// @return True if string @c s matches, or begins with, string @c w of length @c n.
+static bool accept_word(wchar_t *s, const wchar_t *w, size_t n, wchar_t **p)
 {
-    if (!wcsncmp(s, w, wcslen(w))) {
-        s += wcslen(w);
+    if (!wcsncmp(s, w, n)) {
+        s += n;
 
         if (is_eow(s)) {
             if (p) {
@@ -196,8 +50,39 @@ static bool accept_word(wchar_t *s, const wchar_t *w, wchar_t **p)
     return false;
 }
 
+/// Find longest label in the trie of @c ext that matches the start of string @c s.
+/// @return Length of label, or zero if none matches.
+/// @return @c unit is updated with the unit of the matching label.
+static size_t trie_lookup(const struct extension *ext, const wchar_t *s, enum unit *unit)
+{
+    size_t length = 0;
+    uint32_t n = 0;
+
+    for (size_t i = 0; s[i]; ++i) {
+        uint32_t child = ext->node[n].child;
+
+        while (child && ext->node[child].ch != (int32_t)s[i]) {
+            child = ext->node[child].sibling;
+        }
+
+        if (!child) {
+            break;
+        }
+
+        n = child;
+        if (ext->node[n].unit != PresentationUnitNone && is_eow(s + i + 1)) {
+            *unit = (enum unit)ext->node[n].unit;
+            length = i + 1;
+        }
+    }
+
+    return length;
+}
+
 enum unit label_lookup(wchar_t *s, wchar_t **p)
 {
+    const struct extension *ext = extension_get();
+    enum unit unit = PresentationUnitUnknown;
     size_t candidate = 0;
     size_t candidates = 0;
     size_t length = 0;
@@ -209,26 +94,169 @@ enum unit label_lookup(wchar_t *s, wchar_t **p)
     }
 
     for (size_t i = 0; i < sizeof(labels) / sizeof(*labels); ++i) {
-        if (accept_word(s, labels[i].label, NULL)) {
-            // Find longest match.
-            if (wcslen(labels[i].label) > length) {
-                candidate = i;
-                candidates++;;
-                length = wcslen(labels[i].label);
-            }
+        // Find longest match.
+        if (labels[i].length > length && accept_word(s, labels[i].label, labels[i].length, NULL)) {
+            candidate = i;
+            candidates++;
+            length = labels[i].length;
+        }
+    }
+
+    if (ext) {
+        // Labels defined at runtime win unless shorter.
+        size_t n = trie_lookup(ext, s, &unit);
+        if (n && n >= length) {
+            *p = s + n;
+            return unit;
         }
     }
 
     if (candidates) {
-        accept_word(s, labels[candidate].label, p);
+        accept_word(s, labels[candidate].label, labels[candidate].length, p);
         return labels[candidate].unit;
     }
 
-    return PresentationUnitUnknown;
+    return unit;
+}
+
+/// Entry of the normalized label index.
+struct entry {
+    /// Normalized label.
+    wchar_t text[NormalMax];
+    /// Length of normalized label.
+    uint8_t length;
+    /// Unit, or PresentationUnitUnknown if normalization makes the label ambiguous.
+    enum unit unit;
+    /// Index of label in @c labels.
+    uint16_t label;
+};
+
+/// Node of BK-tree of normalized labels, used to find labels within an edit distance.
+struct bk {
+    /// Index of entry.
+    uint16_t entry;
+    /// Index of first child, or zero if none.
+    uint16_t child;
+    /// Index of next sibling, or zero if none.
+    uint16_t sibling;
+    /// Edit distance from parent.
+    uint16_t distance;
+};
+
+#include "label.index"
+
+/// Number of entries.
+static const size_t entry_count = sizeof(entries) / sizeof(*entries);
+
+/// @return Length of the prefix of @c s that matches normalized label @c text at end of word, or zero.
+static size_t accept_normalized(const wchar_t *s, const wchar_t *text)
+{
+    const wchar_t *start = s;
+
+    for (; *text; ++text) {
+        if (*text == L' ') {
+            if (!iswspace(*s)) {
+                return 0;
+            }
+            while (iswspace(*s)) {
+                ++s;
+            }
+        } else if (normal_fold(*s++) != *text) {
+            return 0;
+        }
+    }
+
+    return is_eow(s) ? (size_t)(s - start) : 0;
+}
+
+enum unit label_lookup_tolerant(wchar_t *s, wchar_t **p)
+{
+    enum unit unit = label_lookup(s, p);
+    const struct entry *match = NULL;
+    size_t length = 0;
+    size_t lo = 0;
+    size_t hi;
+
+    // Only a label containing white space could be longer than an exact match.
+    if (unit != PresentationUnitUnknown && !iswspace(**p)) {
+        return unit;
+    }
+
+    // Find first entry that begins with the folded first character.
+    wchar_t first = normal_fold(*s);
+    for (hi = entry_count; lo < hi;) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entries[mid].text[0] < first) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (size_t i = lo; i < entry_count && entries[i].text[0] == first; ++i) {
+        size_t n = accept_normalized(s, entries[i].text);
+        if (n && (!match || entries[i].length > match->length)) {
+            match = &entries[i];
+            length = n;
+        }
+    }
+
+    if (!match || match->unit == PresentationUnitUnknown || s + length <= *p) {
+        return unit;
+    }
+
+    *p = s + length;
+    return match->unit;
+}
+
+const wchar_t *label_suggest(const wchar_t *s)
+{
+    wchar_t text[NormalMax];
+    uint16_t stack[sizeof(tree) / sizeof(*tree)];
+    size_t depth = 0;
+    size_t radius;
+    size_t best_distance = 0;
+    size_t best = SIZE_MAX;
+
+    radius = normal_text(s, text) / 3;
+    stack[depth++] = 0;
+
+    while (depth) {
+        const struct bk *node = &tree[stack[--depth]];
+        size_t d = normal_distance(entries[node->entry].text, text);
+
+        // Of labels at equal distance, the first listed wins, whatever the shape of the tree.
+        if (d <= radius && (best == SIZE_MAX || d < best_distance
+                || (d == best_distance && entries[node->entry].label < best))) {
+            best = entries[node->entry].label;
+            best_distance = radius = d;
+        }
+
+        // Children within the radius of the query, by the triangle inequality.
+        for (uint16_t child = node->child; child; child = tree[child].sibling) {
+            if (tree[child].distance + radius >= d && tree[child].distance <= d + radius) {
+                stack[depth++] = child;
+            }
+        }
+    }
+
+    return best == SIZE_MAX ? NULL : labels[best].label;
+}
+
+const wchar_t *label_builtin(size_t i, enum unit *unit)
+{
+    // The first entry of the table is empty.
+    if (i + 1 >= sizeof(labels) / sizeof(*labels)) {
+        return NULL;
+    }
+
+    *unit = labels[i + 1].unit;
+    return labels[i + 1].label;
 }
 
 void label_synonyms(enum unit unit)
 {
+    const struct extension *ext = extension_get();
     bool output = false;
 
     for (size_t i = 0; i < sizeof(labels) / sizeof(*labels); ++i) {
@@ -241,6 +269,16 @@ void label_synonyms(enum unit unit)
         }
     }
 
+    for (size_t i = 0; ext && i < ext->labels; ++i) {
+        if (unit == (enum unit)ext->label[i].unit) {
+            if (output) {
+                printf(", ");
+            }
+            printf("%ls", ext->strings + ext->label[i].text);
+            output = true;
+        }
+    }
+
     if (output) {
         printf("\n");
     }
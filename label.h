@@ -2,6 +2,10 @@
 
 #include <wchar.h>
 
+/// @return Built-in label @c i, in the order listed in label.hi, with its unit in @c unit, or NULL if there are not
+/// more than @c i built-in labels.
+const wchar_t *label_builtin(size_t i, enum unit *unit);
+
 /// Print synonyms for @c unit to stdout.
 void label_synonyms(enum unit unit);
 
@@ -9,3 +13,14 @@ void label_synonyms(enum unit unit);
 /// @return unit
 /// @return @c p is updated to point to tail of @c s after the matching unit label.
 enum unit label_lookup(wchar_t *s, wchar_t **p);
+
+/// Parse unit label in @c s, as label_lookup, tolerating differences in case, white space, and in degree and
+/// prime symbols.
+/// An exact match is preferred, otherwise a built-in label is accepted if it identifies a unit unambiguously.
+/// @return unit
+/// @return @c p is updated to point to tail of @c s after the matching unit label.
+enum unit label_lookup_tolerant(wchar_t *s, wchar_t **p);
+
+/// Suggest a built-in label near to @c s by edit distance, ignoring differences tolerated by label_lookup_tolerant.
+/// @return Label, or NULL if no label is near.
+const wchar_t *label_suggest(const wchar_t *s);
@@ -0,0 +1,163 @@
+// Generate the normalized label index used by label_lookup_tolerant and label_suggest.
+// The output is C source for the tables of label.c, so that they are read-only and need no construction at runtime.
+
+#include "normal.h"
+#include "unit.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct lookup {
+    /// Label.
+    const wchar_t *label;
+    /// Unit.
+    enum unit unit;
+};
+
+/// Labels, as listed in label.c.
+static const struct lookup labels[] = {
+    { L"", PresentationUnitNone },
+
+#define l(label, unit) { label, unit },
+#include "label.hi"
+};
+
+/// Entry of the normalized label index.
+struct entry {
+    /// Normalized label.
+    wchar_t text[NormalMax];
+    /// Length of normalized label.
+    size_t length;
+    /// Unit, or PresentationUnitUnknown if normalization makes the label ambiguous.
+    enum unit unit;
+    /// Index of label in @c labels.
+    size_t label;
+};
+
+/// Node of BK-tree of normalized labels.
+struct bk {
+    /// Index of entry.
+    size_t entry;
+    /// Index of first child, or zero if none.
+    size_t child;
+    /// Index of next sibling, or zero if none.
+    size_t sibling;
+    /// Edit distance from parent.
+    size_t distance;
+};
+
+/// Normalized label index, sorted by normalized label.
+static struct entry entries[sizeof(labels) / sizeof(*labels)];
+/// Number of entries.
+static size_t entry_count;
+/// BK-tree over @c entries; node zero is the root.
+static struct bk tree[sizeof(labels) / sizeof(*labels)];
+
+/// @return True if @c a and @c b have the same conversion.
+static bool equivalent(enum unit a, enum unit b)
+{
+    enum base base_a;
+    enum base base_b;
+
+    return unit_to_base(0, a, &base_a) == unit_to_base(0, b, &base_b)
+        && unit_to_base(1, a, &base_a) == unit_to_base(1, b, &base_b)
+        && base_a == base_b;
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    return wcscmp(((const struct entry *)a)->text, ((const struct entry *)b)->text);
+}
+
+/// Build normalized label index and BK-tree.
+static void build(void)
+{
+    for (size_t i = 1; i < sizeof(labels) / sizeof(*labels); ++i) {
+        struct entry *e = &entries[entry_count++];
+        e->length = normal_text(labels[i].label, e->text);
+        e->unit = labels[i].unit;
+        e->label = i;
+    }
+
+    qsort(entries, entry_count, sizeof(*entries), compare_entries);
+
+    // Merge labels that are equal after normalization.
+    size_t n = 0;
+    for (size_t i = 0; i < entry_count; ++i) {
+        if (n && !wcscmp(entries[n - 1].text, entries[i].text)) {
+            if (!equivalent(entries[n - 1].unit, entries[i].unit)) {
+                entries[n - 1].unit = PresentationUnitUnknown;
+            }
+        } else {
+            entries[n++] = entries[i];
+        }
+    }
+    entry_count = n;
+
+    for (size_t i = 1; i < entry_count; ++i) {
+        size_t node = 0;
+
+        for (;;) {
+            size_t d = normal_distance(entries[tree[node].entry].text, entries[i].text);
+            size_t child = tree[node].child;
+
+            while (child && tree[child].distance != d) {
+                child = tree[child].sibling;
+            }
+
+            if (!child) {
+                tree[i] = (struct bk){ i, 0, tree[node].child, d };
+                tree[node].child = i;
+                break;
+            }
+
+            node = child;
+        }
+    }
+}
+
+/// Print @c s as a wide string literal.
+static void print_text(const wchar_t *s)
+{
+    printf("L\"");
+
+    for (; *s; ++s) {
+        if (*s == L'"' || *s == L'\\') {
+            printf("\\%c", (char)*s);
+        } else if (*s < 0x80) {
+            printf("%c", (char)*s);
+        } else {
+            printf("\\u%04x", (unsigned)*s);
+        }
+    }
+
+    printf("\"");
+}
+
+int main(void)
+{
+    // The labels have no case outside ASCII, so the index does not depend on locale.
+    build();
+
+    printf("// Generated by label_index.\n\n");
+
+    printf("/// Normalized label index, sorted by normalized label.\n");
+    printf("static const struct entry entries[] = {\n");
+    for (size_t i = 0; i < entry_count; ++i) {
+        printf("    { ");
+        print_text(entries[i].text);
+        printf(", %zu, %d, %zu },\n", entries[i].length, (int)entries[i].unit, entries[i].label);
+    }
+    printf("};\n\n");
+
+    printf("/// BK-tree over @c entries; node zero is the root.\n");
+    printf("static const struct bk tree[] = {\n");
+    for (size_t i = 0; i < entry_count; ++i) {
+        printf("    { %zu, %zu, %zu, %zu },\n", tree[i].entry, tree[i].child, tree[i].sibling, tree[i].distance);
+    }
+    printf("};\n");
+
+    return ferror(stdout) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include "normal.h"
+
+#include <wctype.h>
+
+wchar_t normal_fold(wchar_t c)
+{
+    switch (c) {
+        case L'º':
+        case L'˚':
+            return L'°';
+        case L'‘':
+        case L'’':
+        case L'´':
+            return L'\'';
+        case L'“':
+        case L'”':
+            return L'"';
+        default:
+            return iswspace(c) ? L' ' : (wchar_t)towlower(c);
+    }
+}
+
+size_t normal_text(const wchar_t *s, wchar_t *out)
+{
+    size_t n = 0;
+
+    for (; *s && n < NormalMax - 1; ++s) {
+        wchar_t c = normal_fold(*s);
+        if (c != L' ' || !n || out[n - 1] != L' ') {
+            out[n++] = c;
+        }
+    }
+
+    out[n] = L'\0';
+    return n;
+}
+
+size_t normal_distance(const wchar_t *a, const wchar_t *b)
+{
+    size_t row[NormalMax];
+    size_t nb = wcslen(b);
+
+    for (size_t j = 0; j <= nb; ++j) {
+        row[j] = j;
+    }
+
+    for (size_t i = 1; *a; ++a, ++i) {
+        size_t diagonal = row[0];
+        row[0] = i;
+
+        for (size_t j = 1; j <= nb; ++j) {
+            size_t above = row[j];
+            size_t cost = diagonal + (*a != b[j - 1]);
+
+            cost = above + 1 < cost ? above + 1 : cost;
+            cost = row[j - 1] + 1 < cost ? row[j - 1] + 1 : cost;
+            row[j] = cost;
+            diagonal = above;
+        }
+    }
+
+    return row[nb];
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+#include <wchar.h>
+
+/// Maximum length of a normalized label, including NUL.
+#define NormalMax 32
+
+/// @return Character @c c folded for tolerant comparison.
+/// Degree symbol and quotation mark variants are replaced, white space becomes space, and letters become lower case.
+wchar_t normal_fold(wchar_t c);
+
+/// Normalize string @c s into @c out, folding characters and collapsing white space.
+/// @return Length of normalized string, which is truncated to fit NormalMax.
+size_t normal_text(const wchar_t *s, wchar_t *out);
+
+/// @return Edit distance between normalized strings @c a and @c b.
+size_t normal_distance(const wchar_t *a, const wchar_t *b);
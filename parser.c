@@ -7,52 +7,30 @@
 #include <string.h>
 #include <wctype.h>
 
-struct compound {
-    enum unit first;
-    enum unit second;
-};
-
-/// Compound units.
-static const struct compound compounds[] = {
-    { PresentationUnitFeet,  PresentationUnitInch  },
-    { PresentationUnitPound, PresentationUnitOunce }
-};
-
-/// @return True if unit is the first part of possible compound unit.
-static bool is_compound_first(enum unit unit)
-{
-    for (size_t i = 0; i < sizeof(compounds)/sizeof(*compounds); i++) {
-        if (compounds[i].first == unit) {
-            return true;
-        }
-    }
-    return false;
-}
-
-/// @return True if unit forms the second part of a compound unit.
-static bool is_compound_second(enum unit first, enum unit second)
-{
-    for (size_t i = 0; i < sizeof(compounds)/sizeof(*compounds); i++) {
-        if (compounds[i].first == first && compounds[i].second == second) {
-            return true;
-        }
-    }
-    return false;
-}
-
 enum state {
     S_QUANTITY,
     S_FROM,
     S_SUB_QUANTITY,
     S_SUB_FROM,
-    S_TO
+    S_TO,
+    S_TOLERANCE
 };
 
 struct parser {
     /// Parser state.
     enum state state;
+    /// True if unit labels are matched tolerantly.
+    bool tolerant;
     /// Scratch space for number parsing.
     double scratch;
+    /// Unit of the last part of a compound quantity.
+    enum unit part;
+    /// Destination units.
+    enum unit *targets;
+    /// Number of destination units.
+    size_t count;
+    /// Capacity of @c targets.
+    size_t capacity;
     /// Results.
     struct parser_data data;
 };
@@ -61,7 +39,11 @@ struct parser {
 static void reset(struct parser *pa)
 {
     if (pa) {
+        struct parser keep = *pa;
         memset(pa, 0, sizeof(*pa));
+        pa->tolerant = keep.tolerant;
+        pa->targets = keep.targets;
+        pa->capacity = keep.capacity;
     }
 }
 
@@ -72,15 +54,98 @@ struct parser *parser_new(void)
 
 void parser_delete(struct parser *pa)
 {
+    if (pa) {
+        free(pa->targets);
+    }
     free(pa);
 }
 
+void parser_reset(struct parser *pa)
+{
+    reset(pa);
+}
+
+void parser_tolerant(struct parser *pa, bool tolerant)
+{
+    pa->tolerant = tolerant;
+}
+
+/// Parse unit label in @c s.
+static enum unit lookup(struct parser *pa, wchar_t *s, wchar_t **p)
+{
+    return pa->tolerant ? label_lookup_tolerant(s, p) : label_lookup(s, p);
+}
+
+/// Ensure capacity for @c n destination units.
+/// @return False if memory is exhausted.
+static bool reserve(struct parser *pa, size_t n)
+{
+    enum unit *targets = n <= pa->capacity ? pa->targets : realloc(pa->targets, n * sizeof(*targets));
+
+    if (targets && n > pa->capacity) {
+        pa->targets = targets;
+        pa->capacity = n;
+    }
+
+    return targets != NULL;
+}
+
+/// Parse destination units in @c arg, which has capacity reserved.
+static enum parser_ret destinations(struct parser *pa, wchar_t *arg, wchar_t **out)
+{
+    if (!wcscmp(arg, L"*")) {
+        pa->count += base_units(pa->data.base, pa->targets + pa->count, pa->capacity - pa->count);
+        return PARSE_COMPLETE;
+    }
+
+    for (wchar_t *label = arg, *comma; label; label = comma) {
+        wchar_t *p = NULL;
+
+        comma = wcschr(label, L',');
+        if (comma) {
+            *comma++ = L'\0';
+        }
+
+        if (!*label && label != arg && !comma) {
+            // List continues in next word.
+            return PARSE_AGAIN;
+        }
+
+        enum unit to = lookup(pa, label, &p);
+        if ((p && *p) || !symbol_of_unit(to)) {
+            *out = label;
+            return PARSE_UNKNOWN_UNIT;
+        }
+
+        pa->targets[pa->count++] = to;
+    }
+
+    return PARSE_COMPLETE;
+}
+
+/// Parse destination units in @c arg.
+static enum parser_ret to(struct parser *pa, wchar_t *arg, wchar_t **out)
+{
+    size_t n = wcscmp(arg, L"*") ? 1 : base_units(pa->data.base, NULL, 0);
+
+    for (const wchar_t *p = arg; *p; ++p) {
+        n += *p == L',';
+    }
+
+    return reserve(pa, pa->count + n) ? destinations(pa, arg, out) : (*out = arg, PARSE_INVALID_ARGUMENT);
+}
+
 static enum parser_ret add(struct parser *pa, wchar_t *arg, wchar_t **out)
 {
     wchar_t *p = NULL;
 
     *out = NULL;
 
+    // Words may also be separated by white space within an argument.
+    while (iswspace(*arg)) {
+        ++arg;
+    }
+
     switch (pa->state) {
         default:
         case S_QUANTITY:
@@ -94,21 +159,41 @@ static enum parser_ret add(struct parser *pa, wchar_t *arg, wchar_t **out)
             break;
 
         case S_FROM:
-            pa->data.from = label_lookup(arg, &p);
+            if ((*arg == L'±' || !wcsncmp(arg, L"+/-", 3)) && !pa->data.value_tolerance) {
+                // Tolerance of quantity.
+                p = arg + (*arg == L'±' ? 1 : 3);
+                pa->state = S_TOLERANCE;
+                break;
+            }
+
+            pa->data.from = lookup(pa, arg, &p);
 
             if (!symbol_of_unit(pa->data.from)) {
                 *out = arg;
                 return PARSE_UNKNOWN_UNIT;
             }
 
-            if (is_compound_first(pa->data.from)) {
+            if (unit_compound(pa->data.from, PresentationUnitNone)) {
                 // Possible compound-unit.
+                pa->part = pa->data.from;
                 pa->state = S_SUB_QUANTITY;
             } else {
                 pa->state = S_TO;
             }
 
+            pa->data.value = pa->scratch;
             pa->data.quantity = unit_to_base(pa->scratch, pa->data.from, &pa->data.base);
+            pa->data.tolerance = unit_to_base_tolerance(pa->data.value_tolerance, pa->data.from, &pa->data.base);
+            break;
+
+        case S_TOLERANCE:
+            pa->data.value_tolerance = wcstod(arg, &p);
+            if (p == arg || !(pa->data.value_tolerance >= 0)) {
+                *out = arg;
+                return PARSE_INVALID_NUMBER;
+            }
+
+            pa->state = S_FROM;
             break;
 
         case S_SUB_QUANTITY:
@@ -123,29 +208,30 @@ static enum parser_ret add(struct parser *pa, wchar_t *arg, wchar_t **out)
 
         case S_SUB_FROM:
         {
-            enum unit second = label_lookup(arg, &p);
-            if ((p && *p) || !symbol_of_unit(second)) {
+            enum unit second = lookup(pa, arg, &p);
+            if (!symbol_of_unit(second)) {
                 *out = arg;
                 return PARSE_UNKNOWN_UNIT;
             }
 
-            if (!is_compound_second(pa->data.from, second)) {
+            if (!unit_compound(pa->part, second)) {
                 *out = arg;
                 return PARSE_INVALID_COMPOUND;
             }
 
+            struct unit_conversion conversion;
+            unit_conversion(second, pa->data.from, &conversion);
+            pa->data.value += unit_convert(&conversion, pa->scratch);
             pa->data.quantity += unit_to_base(pa->scratch, second, &pa->data.base);
-            pa->state++;
-            return PARSE_AGAIN;
+
+            // A compound quantity may continue with a lesser part.
+            pa->part = second;
+            pa->state = unit_compound(second, PresentationUnitNone) ? S_SUB_QUANTITY : S_TO;
+            break;
         }
 
         case S_TO:
-            pa->data.to = label_lookup(arg, &p);
-            if ((p && *p) || !symbol_of_unit(pa->data.to)) {
-                *out = arg;
-                return PARSE_UNKNOWN_UNIT;
-            }
-            return PARSE_COMPLETE;
+            return to(pa, arg, out);
     }
 
     if (!p || !*p) {
@@ -166,6 +252,9 @@ enum parser_ret parser_add(struct parser *pa, wchar_t *arg, wchar_t **term, stru
         ret = add(pa, arg, term);
         if (ret == PARSE_COMPLETE) {
             *data = pa->data;
+            data->to = pa->targets[0];
+            data->targets = pa->targets;
+            data->target_count = pa->count;
         }
     }
 
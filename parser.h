@@ -1,16 +1,28 @@
 #include "unit.h"
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <wchar.h>
 
 struct parser_data {
     /// Quantity in base units.
     double quantity;
+    /// Quantity in source units.
+    double value;
+    /// Tolerance of quantity in base units, or zero if none.
+    double tolerance;
+    /// Tolerance of quantity in source units, or zero if none.
+    double value_tolerance;
     /// The base unit.
     enum base base;
     /// The source unit.
     enum unit from;
-    /// The destination unit.
+    /// The destination unit, the first of @c targets.
     enum unit to;
+    /// The destination units, valid until the next call to parser_add.
+    const enum unit *targets;
+    /// Number of destination units.
+    size_t target_count;
 };
 
 enum parser_ret {
@@ -37,8 +49,19 @@ struct parser *parser_new(void);
 /// Destructor.
 void parser_delete(struct parser *);
 
+/// Discard any incomplete input.
+void parser_reset(struct parser *);
+
+/// Tolerate differences in case, white space, and in degree and prime symbols in unit labels.
+/// @see label_lookup_tolerant
+void parser_tolerant(struct parser *, bool tolerant);
+
 /// Add @c word.
-/// Accepts QUANTITY | QUANTITY UNIT | UNIT.
+/// Accepts QUANTITY | QUANTITY UNIT | UNIT, and several of these separated by white space.
+/// The first QUANTITY may be followed by a tolerance, "± TOLERANCE" or "+/- TOLERANCE", in the source unit.
+/// The destination is a unit, a comma separated list of units, or "*" for all units of the base of the source unit.
+/// A list that ends with a comma continues in the next word.
+/// @note The list in @c arg is split in place.
 /// @param term Contains the failed term (number or unit) if this function returns an error.
 /// @return enum parser_ret.
 enum parser_ret parser_add(struct parser *, wchar_t *arg, wchar_t **term, struct parser_data *data);
@@ -0,0 +1,519 @@
+#ifdef HAS_FOPENCOOKIE_GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "record.h"
+#include "uring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Size of read buffer.
+#define BUFFER_SIZE 65536
+
+/// Maximum number of threads.
+#define THREAD_MAX 64
+
+/// Number of buffers of asynchronous reading and writing, each of BUFFER_SIZE bytes.
+#define ASYNC_BUFFERS 4
+
+/// Ensure @c buffer of @c capacity has room for @c n bytes.
+/// @return Buffer, or NULL if memory is exhausted.
+static char *reserve(char **buffer, size_t *capacity, size_t n)
+{
+    char *p = n <= *capacity ? *buffer : realloc(*buffer, n);
+
+    *capacity = p && n > *capacity ? n : *capacity;
+    *buffer = p ? p : *buffer;
+    return p;
+}
+
+int record_read(int fd, record_fn fn, void *context)
+{
+    char *buffer = NULL;
+    size_t capacity = 0;
+    size_t length = 0;
+    size_t number = 0;
+    ssize_t n = 0;
+    int r = reserve(&buffer, &capacity, BUFFER_SIZE + 1) ? 0 : -ENOMEM;
+
+    // The buffer holds @c length bytes not yet processed, followed by room for a NUL.
+    while (!r && ((n = read(fd, buffer + length, capacity - 1 - length)) > 0 || (n < 0 && errno == EINTR))) {
+        size_t start = 0;
+        char *eol;
+
+        length += n > 0 ? (size_t)n : 0;
+
+        while (!r && (eol = memchr(buffer + start, '\n', length - start))) {
+            *eol = '\0';
+            r = fn(context, buffer + start, ++number);
+            start = (size_t)(eol + 1 - buffer);
+        }
+
+        memmove(buffer, buffer + start, length - start);
+        length -= start;
+
+        // A record longer than the buffer.
+        r = r ? r : length + 1 < capacity || reserve(&buffer, &capacity, capacity * 2) ? 0 : -ENOMEM;
+    }
+
+    r = r ? r : n < 0 ? -EIO : 0;
+
+    if (!r && length) {
+        // Last record has no line terminator.
+        buffer[length] = '\0';
+        r = fn(context, buffer, ++number);
+    }
+
+    free(buffer);
+    return r;
+}
+
+/// Range of a mapped file, read by one thread.
+struct range {
+    /// Callback.
+    record_fn fn;
+    /// Context of callback.
+    void *context;
+    /// Records.
+    const char *begin;
+    const char *end;
+    /// Number of records in range, then the line number preceding the range.
+    size_t lines;
+    /// Result.
+    int result;
+    /// Thread.
+    pthread_t thread;
+};
+
+/// Count records of @c range.
+static void *count(void *arg)
+{
+    struct range *range = arg;
+
+    range->lines = 0;
+    for (const char *p = range->begin; (p = memchr(p, '\n', (size_t)(range->end - p))); ++p) {
+        range->lines++;
+    }
+
+    return NULL;
+}
+
+/// Process records of @c range, copying each to a buffer in order to terminate it.
+static void *process(void *arg)
+{
+    struct range *range = arg;
+    char *line = NULL;
+    size_t capacity = 0;
+    size_t number = range->lines;
+
+    for (const char *p = range->begin; !range->result && p < range->end;) {
+        const char *eol = memchr(p, '\n', (size_t)(range->end - p));
+        size_t n = (size_t)((eol ? eol : range->end) - p);
+
+        if (reserve(&line, &capacity, n + 1)) {
+            memcpy(line, p, n);
+            line[n] = '\0';
+        }
+
+        range->result = capacity > n ? range->fn(range->context, line, ++number) : -ENOMEM;
+        p += n + 1;
+    }
+
+    free(line);
+    return NULL;
+}
+
+/// Run @c routine for each of @c n ranges, each in a thread except the last, which runs in the calling thread.
+static void run(struct range *ranges, size_t n, void *(*routine)(void *))
+{
+    size_t started;
+
+    // Ranges for which a thread could not be started also run in the calling thread.
+    for (started = 0; started + 1 < n && !pthread_create(&ranges[started].thread, NULL, routine, &ranges[started]); ++started) {
+    }
+
+    for (size_t t = started; t < n; ++t) {
+        routine(&ranges[t]);
+    }
+
+    for (size_t t = 0; t < started; ++t) {
+        pthread_join(ranges[t].thread, NULL);
+    }
+}
+
+int record_read_parallel(int fd, size_t threads, record_fn fn, void **contexts)
+{
+    struct stat st;
+    const char *map = threads > 1 && !fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0
+        ? mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)
+        : MAP_FAILED;
+
+    if (map == MAP_FAILED) {
+        return record_read(fd, fn, contexts[0]);
+    }
+
+    threads = threads < THREAD_MAX ? threads : THREAD_MAX;
+
+    size_t size = (size_t)st.st_size;
+    struct range ranges[threads];
+    const char *begin = map;
+    size_t lines = 0;
+    int r = 0;
+
+    // Divide at the end of the record containing each nominal boundary.
+    for (size_t t = 0; t < threads; ++t) {
+        const char *end = map + size * (t + 1) / threads;
+        const char *eol;
+
+        end = end > begin ? end : begin;
+        eol = end < map + size ? memchr(end, '\n', (size_t)(map + size - end)) : NULL;
+        end = eol ? eol + 1 : map + size;
+
+        ranges[t] = (struct range){ .fn = fn, .context = contexts[t], .begin = begin, .end = end };
+        begin = end;
+    }
+
+    run(ranges, threads, count);
+
+    for (size_t t = 0; t < threads; ++t) {
+        size_t n = ranges[t].lines;
+        ranges[t].lines = lines;
+        lines += n;
+    }
+
+    run(ranges, threads, process);
+
+    for (size_t t = 0; t < threads && !r; ++t) {
+        r = ranges[t].result;
+    }
+
+    munmap((void *)map, size);
+    return r;
+}
+
+/// Record assembled from consecutive buffers.
+struct carry {
+    /// Record, NUL-terminated.
+    char *line;
+    /// Length of @c line.
+    size_t length;
+    /// Capacity of @c line.
+    size_t capacity;
+};
+
+/// Process the records of @c chunk of @c size bytes, the first of which may continue, and the last of which may be
+/// continued by, the record in @c carry.
+/// Each record in @c chunk is terminated in place.
+/// @return Zero to continue, otherwise the value returned by @c fn.
+static int chunk(struct carry *carry, char *chunk, size_t size, record_fn fn, void *context, size_t *number)
+{
+    int r = 0;
+
+    for (char *p = chunk, *end = chunk + size; !r && p < end;) {
+        char *eol = memchr(p, '\n', (size_t)(end - p));
+        size_t n = (size_t)((eol ? eol : end) - p);
+        size_t need = carry->length + n + 1;
+
+        if (!eol || carry->length) {
+            // A record that spans buffers.
+            r = reserve(&carry->line, &carry->capacity, need > carry->capacity ? 2 * need : need) ? 0 : -ENOMEM;
+            if (!r) {
+                memcpy(carry->line + carry->length, p, n);
+                carry->length += n;
+                carry->line[carry->length] = '\0';
+            }
+        }
+
+        if (eol && !r) {
+            *eol = '\0';
+            r = fn(context, carry->length ? carry->line : p, ++*number);
+            carry->length = 0;
+        }
+
+        p += n + 1;
+    }
+
+    return r;
+}
+
+/// Buffer of asynchronous reading or writing.
+struct slot {
+    /// Number of bytes read or written.
+    size_t done;
+    /// Number of bytes to read or write.
+    size_t length;
+    /// Offset in the file of the first byte of the buffer, or -1 to read or write at the file position.
+    int64_t offset;
+    /// True if a request for the buffer is in flight.
+    bool busy;
+};
+
+/// Read records of @c fd with io_uring instance @c u, as record_read_async.
+static int read_ring(struct uring *u, int fd, record_fn fn, void *context)
+{
+    // Reads of a regular file are at explicit offsets, so that several may be in flight; other reads are at the file
+    // position, one at a time, so that they complete in order.
+    struct stat st;
+    bool regular = !fstat(fd, &st) && S_ISREG(st.st_mode);
+    int64_t consumed = regular ? lseek(fd, 0, SEEK_CUR) : -1;
+    int64_t position = consumed;
+    unsigned limit = regular ? ASYNC_BUFFERS : 1;
+    struct slot slots[ASYNC_BUFFERS] = { { 0 } };
+    struct carry carry = { 0 };
+    size_t submitted = 0;
+    size_t processed = 0;
+    size_t number = 0;
+    unsigned inflight = 0;
+    bool eof = false;
+    int r = 0;
+
+    while (!r) {
+        // Keep reads in flight ahead of processing.
+        while (!eof && submitted - processed < ASYNC_BUFFERS && inflight < limit) {
+            unsigned i = (unsigned)(submitted++ % ASYNC_BUFFERS);
+
+            slots[i] = (struct slot){ 0, BUFFER_SIZE, position, true };
+            uring_read(u, fd, i, 0, BUFFER_SIZE, position);
+            position += regular ? BUFFER_SIZE : 0;
+            inflight++;
+        }
+
+        struct slot *next = &slots[processed % ASYNC_BUFFERS];
+
+        if (processed == submitted) {
+            break;
+
+        } else if (next->busy) {
+            unsigned i = 0;
+            int result = 0;
+
+            r = uring_complete(u, true, &i, &result) < 0 || result < 0 ? -EIO : 0;
+            inflight--;
+            slots[i].done += result > 0 ? (size_t)result : 0;
+            eof = eof || result <= 0;
+
+            // A short read of a regular file is continued, to the end of the file.
+            slots[i].busy = regular && result > 0 && slots[i].done < slots[i].length;
+            if (slots[i].busy) {
+                uring_read(u, fd, i, slots[i].done, slots[i].length - slots[i].done,
+                    slots[i].offset + (int64_t)slots[i].done);
+                inflight++;
+            }
+
+        } else {
+            r = chunk(&carry, uring_buffer(u, (unsigned)(processed % ASYNC_BUFFERS)), next->done, fn, context, &number);
+            consumed += regular ? (int64_t)next->done : 0;
+            processed++;
+        }
+    }
+
+    // Buffers are released only when no request uses them.
+    for (unsigned i = 0; inflight && uring_complete(u, true, &i, &(int){ 0 }) > 0; --inflight) {
+    }
+
+    if (!r && carry.length) {
+        // Last record has no line terminator.
+        r = fn(context, carry.line, ++number);
+    }
+
+    // Leave the file position after the records read, as record_read.
+    if (regular) {
+        lseek(fd, consumed, SEEK_SET);
+    }
+
+    free(carry.line);
+    return r;
+}
+
+int record_read_async(int fd, record_fn fn, void *context)
+{
+    struct uring *u;
+    int r = uring_new(ASYNC_BUFFERS, BUFFER_SIZE, &u);
+
+    // Without io_uring, records are read synchronously.
+    r = r ? record_read(fd, fn, context) : read_ring(u, fd, fn, context);
+    uring_delete(u);
+    return r;
+}
+
+#if defined(HAS_IO_URING) && defined(HAS_FOPENCOOKIE_GNU_SOURCE)
+
+/// Stream writing to a file through io_uring.
+struct writer {
+    /// io_uring instance.
+    struct uring *ring;
+    /// File.
+    int fd;
+    /// True if writes are at explicit offsets, so that several may be in flight, otherwise they are at the file
+    /// position, one at a time, so that they complete in order.
+    bool regular;
+    /// Offset of the next write, if @c regular.
+    int64_t position;
+    /// Maximum number of writes in flight.
+    unsigned limit;
+    /// Number of writes in flight.
+    unsigned inflight;
+    /// Buffer being filled.
+    unsigned current;
+    /// Buffers; the length of the current buffer is the number of bytes it holds.
+    struct slot slots[ASYNC_BUFFERS];
+    /// Error number of the first failed write, or zero.
+    int error;
+};
+
+/// Write the rest of buffer @c i of writer @c w.
+static void put(struct writer *w, unsigned i)
+{
+    struct slot *s = &w->slots[i];
+
+    uring_write(w->ring, w->fd, i, s->done, s->length - s->done, s->offset < 0 ? -1 : s->offset + (int64_t)s->done);
+    s->busy = true;
+    w->inflight++;
+}
+
+/// Reap a completed write of writer @c w, waiting for one if @c wait.
+/// @return True if a write completed.
+static bool reap(struct writer *w, bool wait)
+{
+    unsigned i = 0;
+    int result = 0;
+    int n = uring_complete(w->ring, wait, &i, &result);
+
+    if (n > 0) {
+        struct slot *s = &w->slots[i];
+
+        w->inflight--;
+        w->error = w->error || result > 0 ? w->error : result < 0 ? -result : EIO;
+        s->done += result > 0 ? (size_t)result : 0;
+        s->busy = false;
+
+        // A short write is continued.
+        if (result > 0 && s->done < s->length) {
+            put(w, i);
+        }
+    }
+
+    w->error = w->error || n >= 0 ? w->error : -n;
+    return n > 0;
+}
+
+/// Write the buffer being filled by writer @c w, if it is not empty, and make the next buffer current once it is
+/// free.
+static void send(struct writer *w)
+{
+    struct slot *s = &w->slots[w->current];
+
+    while (!w->error && w->inflight >= w->limit && reap(w, true)) {
+    }
+
+    if (!w->error && s->length) {
+        s->done = 0;
+        s->offset = w->regular ? w->position : -1;
+        w->position += (int64_t)s->length;
+        put(w, w->current);
+        w->current = (w->current + 1) % ASYNC_BUFFERS;
+    }
+
+    while (!w->error && w->slots[w->current].busy && reap(w, true)) {
+    }
+
+    w->slots[w->current].length = 0;
+}
+
+static ssize_t writer_write(void *cookie, const char *data, size_t size)
+{
+    struct writer *w = cookie;
+
+    while (!w->error && reap(w, false)) {
+    }
+
+    for (size_t n = size; !w->error && n;) {
+        struct slot *s = &w->slots[w->current];
+        size_t k = n < BUFFER_SIZE - s->length ? n : BUFFER_SIZE - s->length;
+
+        memcpy(uring_buffer(w->ring, w->current) + s->length, data, k);
+        s->length += k;
+        data += k;
+        n -= k;
+
+        if (s->length == BUFFER_SIZE) {
+            send(w);
+        }
+    }
+
+    // Output is written as soon as no write is in flight, so that it is not held back waiting for a full buffer.
+    if (!w->error && !w->inflight) {
+        send(w);
+    }
+
+    return w->error ? (errno = w->error, -1) : (ssize_t)size;
+}
+
+/// Delete writer @c w, which has no writes in flight.
+static void discard(struct writer *w)
+{
+    if (w) {
+        uring_delete(w->ring);
+    }
+    free(w);
+}
+
+static int writer_close(void *cookie)
+{
+    struct writer *w = cookie;
+    int error;
+
+    send(w);
+    while (w->inflight && reap(w, true)) {
+    }
+
+    // Leave the file position after the bytes written.
+    if (w->regular) {
+        lseek(w->fd, w->position, SEEK_SET);
+    }
+
+    error = w->error;
+    discard(w);
+    return error ? (errno = error, -1) : 0;
+}
+
+FILE *record_write_async(int fd)
+{
+    struct writer *w = calloc(1, sizeof(*w));
+    struct stat st;
+    FILE *f = NULL;
+
+    if (w && !uring_new(ASYNC_BUFFERS, BUFFER_SIZE, &w->ring)) {
+        // A file opened to append is written at its end, whatever the offset, so it is written in order.
+        w->fd = fd;
+        w->regular = !fstat(fd, &st) && S_ISREG(st.st_mode) && !(fcntl(fd, F_GETFL) & O_APPEND);
+        w->position = w->regular ? lseek(fd, 0, SEEK_CUR) : -1;
+        w->limit = w->regular ? ASYNC_BUFFERS : 1;
+        f = fopencookie(w, "w", (cookie_io_functions_t){ .write = writer_write, .close = writer_close });
+    }
+
+    // The stream is buffered as the file, so that a write fills a buffer unless the stream is flushed.
+    if (f) {
+        setvbuf(f, NULL, _IOFBF, BUFFER_SIZE);
+    }
+
+    return f ? f : (discard(w), NULL);
+}
+
+#else
+
+FILE *record_write_async(int fd)
+{
+    (void)fd;
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+
+/// Process one record.
+/// @param context Context of the reader, or of the thread reading the record.
+/// @param line Record, NUL-terminated, without its line terminator.
+/// @param number Line number of the record, from one.
+/// @return Zero to continue, otherwise reading stops and this value is returned.
+typedef int (*record_fn)(void *context, char *line, size_t number);
+
+/// Read newline-separated records from file descriptor @c fd, calling @c fn for each, in order.
+/// Memory is bounded by the longest record.
+/// @return Zero on success, negative otherwise, or the value returned by @c fn.
+/// @return -EIO If @c fd cannot be read.
+int record_read(int fd, record_fn fn, void *context);
+
+/// Read newline-separated records as record_read, using @c threads threads with one context each.
+/// If @c fd is a regular file it is mapped and divided into @c threads ranges of whole records, read in parallel;
+/// otherwise the records are read in order, with the first context.
+/// @return Zero on success, negative otherwise, or a value returned by @c fn.
+int record_read_parallel(int fd, size_t threads, record_fn fn, void **contexts);
+
+/// Read newline-separated records as record_read, with reads submitted through io_uring ahead of processing, so that
+/// reading overlaps with @c fn.
+/// Several reads of a regular file are in flight at once; other files are read one buffer ahead.
+/// If io_uring is not available, records are read by record_read.
+int record_read_async(int fd, record_fn fn, void *context);
+
+/// Open a stream that writes to file descriptor @c fd through io_uring, so that writing overlaps with the caller.
+/// Several writes to a regular file are in flight at once; other files are written one buffer at a time.
+/// Closing the stream waits for its writes, and does not close @c fd.
+/// @return Stream, or NULL if io_uring is not available.
+FILE *record_write_async(int fd);
@@ -0,0 +1,81 @@
+#include "reload.h"
+#include "definition.h"
+#include "extension.h"
+
+#include <pthread.h>
+#include <time.h>
+
+/// Serializes reloads. Readers of the extension do not take it.
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Current definitions, or NULL.
+static struct definitions *current;
+
+/// Metrics, guarded by @c mutex.
+static struct reload_metrics metrics;
+
+/// @return Monotonic time in nanoseconds.
+static uint64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/// Install @c defs, and release the current definitions once no thread reads them.
+/// @return Nanoseconds taken.
+static uint64_t swap(struct definitions *defs)
+{
+    uint64_t start = now();
+
+    extension_set(defs ? definitions_extension(defs) : NULL);
+    extension_synchronize();
+    definitions_delete(current);
+    current = defs;
+
+    return now() - start;
+}
+
+int reload(const char *path, size_t *line)
+{
+    struct definitions *defs;
+    uint64_t start;
+    int r;
+
+    pthread_mutex_lock(&mutex);
+
+    start = now();
+    r = definitions_load(path, &defs, line);
+
+    if (r) {
+        metrics.failures++;
+    } else {
+        size_t bytes = definitions_size(defs);
+        size_t peak = bytes + (current ? definitions_size(current) : 0);
+
+        metrics.build_ns = now() - start;
+        metrics.swap_ns = swap(defs);
+        metrics.swap_max_ns = metrics.swap_ns > metrics.swap_max_ns ? metrics.swap_ns : metrics.swap_max_ns;
+        metrics.peak_bytes = peak > metrics.peak_bytes ? peak : metrics.peak_bytes;
+        metrics.bytes = bytes;
+        metrics.version++;
+    }
+
+    pthread_mutex_unlock(&mutex);
+    return r;
+}
+
+void reload_release(void)
+{
+    pthread_mutex_lock(&mutex);
+    swap(NULL);
+    metrics.bytes = 0;
+    pthread_mutex_unlock(&mutex);
+}
+
+void reload_metrics(struct reload_metrics *m)
+{
+    pthread_mutex_lock(&mutex);
+    *m = metrics;
+    pthread_mutex_unlock(&mutex);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Metrics of definitions reloaded at runtime.
+struct reload_metrics {
+    /// Number of definitions loaded, which is the version of the current definitions.
+    uint64_t version;
+    /// Number of reloads that failed, leaving the current definitions in place.
+    uint64_t failures;
+    /// Nanoseconds taken to build or map the current definitions.
+    uint64_t build_ns;
+    /// Nanoseconds from installing the current definitions until the previous could be released,
+    /// that is until no thread read them, and the greatest such time.
+    uint64_t swap_ns;
+    uint64_t swap_max_ns;
+    /// Bytes held by the current definitions, and the greatest held at once, during a swap.
+    size_t bytes;
+    size_t peak_bytes;
+};
+
+/// Load definitions from file @c path, in the calling thread, and install them as the current extension.
+/// The previous definitions are released once no thread reads them; threads reading them are not interrupted,
+/// and continue to see them until extension_leave.
+/// Reloads are serialized, so that no more than two sets of definitions are held at once.
+/// @note Must not be called between extension_enter and extension_leave.
+/// @param line Updated with the number of the line containing a malformed definition.
+/// @return Zero on success, negative otherwise, as definitions_load.
+int reload(const char *path, size_t *line);
+
+/// Remove and release the current definitions, once no thread reads them.
+void reload_release(void);
+
+/// Get @c metrics.
+void reload_metrics(struct reload_metrics *metrics);
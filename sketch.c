@@ -0,0 +1,320 @@
+#include "sketch.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+/// Magic number and version of serialized form.
+static const uint8_t magic[] = { 'U', 'S', 'K', 1 };
+
+int sketch_init(struct sketch *s, double accuracy)
+{
+    if (!(accuracy > 0 && accuracy < 1)) {
+        return -EINVAL;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->accuracy = accuracy;
+    s->log_gamma = log((1 + accuracy) / (1 - accuracy));
+    return 0;
+}
+
+/// Shift the bins of @c store up by @c by keys, collapsing those that fall below the first bin into it.
+static void shift(struct sketch_store *store, int64_t by)
+{
+    size_t n = by < SKETCH_BINS ? (size_t)by : SKETCH_BINS;
+    uint64_t collapsed = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        collapsed += store->bins[i];
+    }
+
+    memmove(store->bins, store->bins + n, (SKETCH_BINS - n) * sizeof(*store->bins));
+    memset(store->bins + SKETCH_BINS - n, 0, n * sizeof(*store->bins));
+    store->bins[0] += collapsed;
+    store->offset += by;
+}
+
+/// Add @c count values of @c key to @c store.
+static void store_add(struct sketch_store *store, int64_t key, uint64_t count)
+{
+    // Center an empty store on its first key, leaving room above and below.
+    store->offset = store->count ? store->offset : key - SKETCH_BINS / 2;
+
+    if (key >= store->offset + SKETCH_BINS) {
+        shift(store, key - (store->offset + SKETCH_BINS - 1));
+    }
+
+    store->bins[key > store->offset ? key - store->offset : 0] += count;
+    store->count += count;
+}
+
+/// @return Key of @c magnitude, which is positive.
+static int64_t key(const struct sketch *s, double magnitude)
+{
+    return (int64_t)ceil(log(magnitude) / s->log_gamma);
+}
+
+/// @return Greatest magnitude of bin @c key.
+static double upper(const struct sketch *s, int64_t key)
+{
+    return exp((double)key * s->log_gamma);
+}
+
+/// @return Estimate of magnitudes of bin @c key, which has least relative error over the bin.
+static double estimate(const struct sketch *s, int64_t key)
+{
+    return 2 * upper(s, key) / (1 + exp(s->log_gamma));
+}
+
+int sketch_add(struct sketch *s, double value)
+{
+    if (!isfinite(value)) {
+        return -EINVAL;
+    }
+
+    if (value > 0) {
+        store_add(&s->positive, key(s, value), 1);
+    } else if (value < 0) {
+        store_add(&s->negative, key(s, -value), 1);
+    } else {
+        s->zero++;
+    }
+
+    return 0;
+}
+
+/// Merge @c other into @c store.
+static void store_merge(struct sketch_store *store, const struct sketch_store *other)
+{
+    for (size_t i = 0; i < SKETCH_BINS; ++i) {
+        if (other->bins[i]) {
+            store_add(store, other->offset + (int64_t)i, other->bins[i]);
+        }
+    }
+}
+
+int sketch_merge(struct sketch *s, const struct sketch *other)
+{
+    if (s->accuracy != other->accuracy) {
+        return -EINVAL;
+    }
+
+    s->zero += other->zero;
+    store_merge(&s->negative, &other->negative);
+    store_merge(&s->positive, &other->positive);
+    return 0;
+}
+
+uint64_t sketch_count(const struct sketch *s)
+{
+    return s->negative.count + s->zero + s->positive.count;
+}
+
+double sketch_quantile(const struct sketch *s, double q)
+{
+    uint64_t count = sketch_count(s);
+
+    if (!count || !(q >= 0 && q <= 1)) {
+        return NAN;
+    }
+
+    // Rank of the value, from zero.
+    uint64_t rank = (uint64_t)(q * (double)(count - 1));
+    size_t i;
+
+    if (rank < s->negative.count) {
+        // Negative values, in descending order of magnitude.
+        for (i = SKETCH_BINS - 1; s->negative.bins[i] <= rank; --i) {
+            rank -= s->negative.bins[i];
+        }
+        return -estimate(s, s->negative.offset + (int64_t)i);
+    }
+
+    rank -= s->negative.count;
+    if (rank < s->zero) {
+        return 0;
+    }
+
+    rank -= s->zero;
+    for (i = 0; s->positive.bins[i] <= rank; ++i) {
+        rank -= s->positive.bins[i];
+    }
+    return estimate(s, s->positive.offset + (int64_t)i);
+}
+
+/// Append bin of @c count values between @c lower and @c upper to @c bins of @c size, of which there are @c n.
+static void append(struct sketch_bin *bins, size_t size, size_t *n, double lower, double upper, uint64_t count)
+{
+    if (*n < size) {
+        bins[*n] = (struct sketch_bin){ lower, upper, count };
+    }
+    ++*n;
+}
+
+size_t sketch_histogram(const struct sketch *s, struct sketch_bin *bins, size_t size)
+{
+    size_t n = 0;
+
+    for (size_t i = SKETCH_BINS; i-- > 0;) {
+        int64_t k = s->negative.offset + (int64_t)i;
+        if (s->negative.bins[i]) {
+            append(bins, size, &n, -upper(s, k), -upper(s, k - 1), s->negative.bins[i]);
+        }
+    }
+
+    if (s->zero) {
+        append(bins, size, &n, 0, 0, s->zero);
+    }
+
+    for (size_t i = 0; i < SKETCH_BINS; ++i) {
+        int64_t k = s->positive.offset + (int64_t)i;
+        if (s->positive.bins[i]) {
+            append(bins, size, &n, upper(s, k - 1), upper(s, k), s->positive.bins[i]);
+        }
+    }
+
+    return n;
+}
+
+/// Serialized form being written.
+struct writer {
+    uint8_t *buffer;
+    size_t size;
+    size_t length;
+};
+
+/// Write byte @c b.
+static void put(struct writer *w, uint8_t b)
+{
+    if (w->length < w->size) {
+        w->buffer[w->length] = b;
+    }
+    w->length++;
+}
+
+/// Write @c v as base-128 varint.
+static void put_varint(struct writer *w, uint64_t v)
+{
+    for (; v >= 0x80; v >>= 7) {
+        put(w, (uint8_t)(v | 0x80));
+    }
+    put(w, (uint8_t)v);
+}
+
+/// Write bins of @c store, as their number, then the difference from the previous key and count of each.
+static void put_store(struct writer *w, const struct sketch_store *store)
+{
+    size_t n = 0;
+    int64_t previous = 0;
+
+    for (size_t i = 0; i < SKETCH_BINS; ++i) {
+        n += store->bins[i] != 0;
+    }
+
+    put_varint(w, n);
+
+    for (size_t i = 0; i < SKETCH_BINS; ++i) {
+        if (store->bins[i]) {
+            int64_t k = store->offset + (int64_t)i;
+            uint64_t delta = (uint64_t)k - (uint64_t)previous;
+
+            // Zigzag encoding, so that the first key may be negative.
+            put_varint(w, (delta << 1) ^ (uint64_t)-(int64_t)(delta >> 63));
+            put_varint(w, store->bins[i]);
+            previous = k;
+        }
+    }
+}
+
+size_t sketch_serialize(const struct sketch *s, uint8_t *buffer, size_t size)
+{
+    struct writer w = { buffer, size, 0 };
+    uint64_t accuracy;
+
+    memcpy(&accuracy, &s->accuracy, sizeof(accuracy));
+
+    for (size_t i = 0; i < sizeof(magic); ++i) {
+        put(&w, magic[i]);
+    }
+    for (size_t i = 0; i < sizeof(accuracy); ++i) {
+        put(&w, (uint8_t)(accuracy >> (8 * i)));
+    }
+
+    put_varint(&w, s->zero);
+    put_store(&w, &s->negative);
+    put_store(&w, &s->positive);
+    return w.length;
+}
+
+/// Serialized form being read.
+struct reader {
+    const uint8_t *p;
+    const uint8_t *end;
+};
+
+/// Read base-128 varint.
+/// @return Zero on success, negative otherwise.
+static int get_varint(struct reader *r, uint64_t *v)
+{
+    *v = 0;
+
+    for (unsigned shift = 0; r->p < r->end && shift < 64; shift += 7) {
+        uint8_t b = *r->p++;
+        *v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return 0;
+        }
+    }
+
+    return -EINVAL;
+}
+
+/// Read bins into @c store.
+/// @return Zero on success, negative otherwise.
+static int get_store(struct reader *r, const struct sketch *s, struct sketch_store *store)
+{
+    uint64_t n;
+    uint64_t previous = 0;
+    int e = get_varint(r, &n);
+
+    for (uint64_t i = 0; !e && i < n; ++i) {
+        uint64_t delta;
+        uint64_t count;
+
+        e = get_varint(r, &delta) || get_varint(r, &count) || !count ? -EINVAL : 0;
+        previous += (delta >> 1) ^ (uint64_t)-(int64_t)(delta & 1);
+
+        // Keys are those of finite values, which are within the range of the logarithm of a double.
+        e = e ? e : fabs((double)(int64_t)previous * s->log_gamma) > 1000 ? -EINVAL : 0;
+
+        if (!e) {
+            store_add(store, (int64_t)previous, count);
+        }
+    }
+
+    return e;
+}
+
+int sketch_deserialize(struct sketch *s, const uint8_t *buffer, size_t size)
+{
+    struct reader r = { buffer, buffer + size };
+    uint64_t accuracy = 0;
+    double a;
+
+    if (size < sizeof(magic) + sizeof(accuracy) || memcmp(buffer, magic, sizeof(magic))) {
+        return -EINVAL;
+    }
+
+    r.p += sizeof(magic);
+    for (size_t i = 0; i < sizeof(accuracy); ++i) {
+        accuracy |= (uint64_t)*r.p++ << (8 * i);
+    }
+    memcpy(&a, &accuracy, sizeof(a));
+
+    int e = sketch_init(s, a);
+    e = e ? e : get_varint(&r, &s->zero);
+    e = e ? e : get_store(&r, s, &s->negative);
+    e = e ? e : get_store(&r, s, &s->positive);
+    return e ? e : r.p == r.end ? 0 : -EINVAL;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Number of bins for values of each sign.
+#define SKETCH_BINS 2048
+
+/// Bins of a sketch for values of one sign, indexed by key less offset.
+struct sketch_store {
+    /// Key of first bin.
+    int64_t offset;
+    /// Number of values.
+    uint64_t count;
+    /// Number of values in each bin.
+    uint64_t bins[SKETCH_BINS];
+};
+
+/// Quantile sketch with relative accuracy (DDSketch), in constant memory.
+/// A value x is counted in the bin with key ceil(log(|x|) / log(gamma)), where gamma = (1 + accuracy) / (1 - accuracy),
+/// so that any quantile is estimated to within @c accuracy of the value of that rank.
+/// If the values span more bins than the store holds, the lowest bins are collapsed, losing accuracy only there.
+/// Sketches of the same accuracy may be merged.
+struct sketch {
+    /// Relative accuracy.
+    double accuracy;
+    /// Logarithm of gamma.
+    double log_gamma;
+    /// Number of zero values.
+    uint64_t zero;
+    /// Negative values, by magnitude.
+    struct sketch_store negative;
+    /// Positive values.
+    struct sketch_store positive;
+};
+
+/// Bin of a histogram of a sketch.
+struct sketch_bin {
+    /// Least and greatest value of bin.
+    double lower;
+    double upper;
+    /// Number of values.
+    uint64_t count;
+};
+
+/// Initialize empty sketch @c s with relative @c accuracy.
+/// @return Zero on success, negative otherwise.
+/// @return -EINVAL If @c accuracy is not between zero and one.
+int sketch_init(struct sketch *s, double accuracy);
+
+/// Add @c value to @c s.
+/// @return Zero on success, negative otherwise.
+/// @return -EINVAL If @c value is not finite.
+int sketch_add(struct sketch *s, double value);
+
+/// Merge @c other into @c s.
+/// @return Zero on success, negative otherwise.
+/// @return -EINVAL If the accuracy of the sketches differs.
+int sketch_merge(struct sketch *s, const struct sketch *other);
+
+/// @return Number of values of @c s.
+uint64_t sketch_count(const struct sketch *s);
+
+/// @return Estimate of quantile @c q of @c s, or NaN if @c s is empty or @c q is not between zero and one.
+double sketch_quantile(const struct sketch *s, double q);
+
+/// Enumerate the non-empty bins of @c s in ascending order.
+/// @param bins Updated with at most @c size bins; may be NULL if @c size is zero.
+/// @return Number of non-empty bins, which may exceed @c size.
+size_t sketch_histogram(const struct sketch *s, struct sketch_bin *bins, size_t size);
+
+/// Serialize @c s into @c buffer of @c size bytes, in a compact form that lists non-empty bins only.
+/// @return Length of serialized form, which may exceed @c size, in which case @c buffer is incomplete.
+size_t sketch_serialize(const struct sketch *s, uint8_t *buffer, size_t size);
+
+/// Deserialize @c s from @c buffer of @c size bytes.
+/// @return Zero on success, negative otherwise.
+/// @return -EINVAL If @c buffer is not a serialized sketch.
+int sketch_deserialize(struct sketch *s, const uint8_t *buffer, size_t size);
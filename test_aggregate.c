@@ -0,0 +1,115 @@
+#include "aggregate.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+
+static void test_empty(void)
+{
+    struct aggregate a;
+
+    aggregate_init(&a);
+    assert(0 == a.count);
+    assert(0 == aggregate_sum(&a));
+    assert(isnan(aggregate_mean(&a)));
+    assert(isnan(aggregate_quantile(&a, 0.5)));
+}
+
+static void test_add(void)
+{
+    struct aggregate a;
+
+    aggregate_init(&a);
+    assert(!aggregate_add(&a, 3.2, BaseUnitKilogram));
+    assert(!aggregate_add(&a, 0.5, BaseUnitKilogram));
+    assert(!aggregate_add(&a, 1, BaseUnitKilogram));
+    assert(-EPERM == aggregate_add(&a, 1, BaseUnitMetre));
+    assert(-EINVAL == aggregate_add(&a, INFINITY, BaseUnitKilogram));
+
+    assert(3 == a.count);
+    assert(BaseUnitKilogram == a.base);
+    assert(4.7 == aggregate_sum(&a));
+    assert(0.5 == a.min);
+    assert(3.2 == a.max);
+    assert(fabs(aggregate_quantile(&a, 0.5) - 1) <= AGGREGATE_ACCURACY);
+}
+
+static void test_compensation(void)
+{
+    struct aggregate a;
+
+    // Naive summation loses the small quantities entirely.
+    aggregate_init(&a);
+    assert(!aggregate_add(&a, 1, BaseUnitMetre));
+    for (int i = 0; i < 1000; ++i) {
+        assert(!aggregate_add(&a, 1e-16, BaseUnitMetre));
+    }
+    assert(!aggregate_add(&a, 1e100, BaseUnitMetre));
+    assert(!aggregate_add(&a, -1e100, BaseUnitMetre));
+
+    assert(fabs(1 + 1e-13 - aggregate_sum(&a)) < 1e-15);
+}
+
+static void test_signed(void)
+{
+    struct aggregate a;
+
+    // Temperatures in °C, as summarized for printing in °C rather than in kelvin.
+    aggregate_init(&a);
+    assert(!aggregate_add(&a, -10, BaseUnitKelvin));
+    assert(!aggregate_add(&a, 20, BaseUnitKelvin));
+    assert(!aggregate_add(&a, 25, BaseUnitKelvin));
+    assert(!aggregate_add(&a, 30, BaseUnitKelvin));
+
+    assert(-10 == a.min);
+    assert(16.25 == aggregate_mean(&a));
+    assert(fabs(aggregate_quantile(&a, 0) + 10) <= 10 * AGGREGATE_ACCURACY);
+    assert(fabs(aggregate_quantile(&a, 0.5) - 20) <= 20 * AGGREGATE_ACCURACY);
+    assert(fabs(aggregate_quantile(&a, 1) - 30) <= 30 * AGGREGATE_ACCURACY);
+}
+
+static void test_merge(void)
+{
+    struct aggregate a;
+    struct aggregate b;
+    struct aggregate c;
+
+    aggregate_init(&a);
+    aggregate_init(&b);
+    aggregate_init(&c);
+
+    // Empty into empty.
+    assert(!aggregate_merge(&a, &b));
+    assert(0 == a.count);
+
+    assert(!aggregate_add(&b, 2, BaseUnitKelvin));
+    assert(!aggregate_add(&b, 4, BaseUnitKelvin));
+    assert(!aggregate_add(&c, 1, BaseUnitMetre));
+
+    // Into empty.
+    assert(!aggregate_merge(&a, &b));
+    assert(BaseUnitKelvin == a.base);
+    assert(-EPERM == aggregate_merge(&a, &c));
+
+    // Twice.
+    assert(!aggregate_merge(&a, &b));
+    assert(4 == a.count);
+    assert(12 == aggregate_sum(&a));
+    assert(3 == aggregate_mean(&a));
+    assert(2 == a.min);
+    assert(4 == a.max);
+    assert(fabs(aggregate_quantile(&a, 0) - 2) <= 2 * AGGREGATE_ACCURACY);
+    assert(fabs(aggregate_quantile(&a, 1) - 4) <= 4 * AGGREGATE_ACCURACY);
+}
+
+int main(void)
+{
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    test_empty();
+    test_add();
+    test_compensation();
+    test_signed();
+    test_merge();
+}
@@ -0,0 +1,140 @@
+#include "cache.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @return True if @c key is cached with value @c expected.
+static bool cached(struct cache *c, const char *key, const char *expected)
+{
+    size_t length;
+    const char *value = cache_get(c, key, strlen(key), &length);
+
+    return value && length == strlen(expected) && !memcmp(value, expected, length);
+}
+
+static void test_new(void)
+{
+    struct cache *c = (struct cache *)&c;
+
+    assert(-EINVAL == cache_new(0, &c));
+    assert(!c);
+    assert(-EINVAL == cache_new(((size_t)1 << 30) + 1, &c));
+
+    cache_delete(NULL);
+}
+
+static void test_get(void)
+{
+    struct cache *c;
+    struct cache_metrics m;
+    char big[CACHE_ENTRY_MAX + 1];
+    size_t length;
+
+    assert(!cache_new(4, &c));
+
+    assert(!cache_get(c, "20 °C K", strlen("20 °C K"), &length));
+    assert(cache_put(c, "20 °C K", strlen("20 °C K"), "20 °C is 293.15 K\n", strlen("20 °C is 293.15 K\n")));
+    assert(!cache_get(c, "1 ft m", 6, &length));
+    assert(cache_put(c, "1 ft m", 6, "1 ' is 0.3048 m\n", 16));
+    assert(cached(c, "1 ft m", "1 ' is 0.3048 m\n"));
+
+    // Keys are compared whole.
+    assert(!cached(c, "1 ft", ""));
+    assert(cache_put(c, "", 0, "empty", 5));
+    assert(cached(c, "", "empty"));
+
+    // Too long.
+    memset(big, 'x', sizeof(big));
+    assert(!cache_put(c, big, 1, big, CACHE_ENTRY_MAX));
+    assert(cache_put(c, big, 1, big, CACHE_ENTRY_MAX - 1));
+
+    cache_metrics(c, &m);
+    assert(m.hits == 2 && m.misses == 3 && m.evictions == 0 && m.entries == 4);
+
+    cache_clear(c);
+    assert(!cached(c, "", "empty"));
+    cache_metrics(c, &m);
+    assert(m.hits == 2 && m.misses == 4 && m.entries == 0);
+
+    cache_delete(c);
+}
+
+static void test_clock(void)
+{
+    struct cache *c;
+    struct cache_metrics m;
+
+    assert(!cache_new(3, &c));
+    assert(cache_put(c, "a", 1, "1", 1));
+    assert(cache_put(c, "b", 1, "2", 1));
+    assert(cache_put(c, "c", 1, "3", 1));
+
+    // Entries found since the hand passed are spared once.
+    assert(cached(c, "a", "1"));
+    assert(cached(c, "c", "3"));
+    assert(cache_put(c, "d", 1, "4", 1));
+    assert(!cached(c, "b", "2"));
+    assert(cached(c, "a", "1") && cached(c, "c", "3") && cached(c, "d", "4"));
+
+    // Every entry is referenced, so the hand passes all of them once.
+    assert(cache_put(c, "e", 1, "5", 1));
+    assert(!cached(c, "c", "3"));
+
+    cache_metrics(c, &m);
+    assert(m.evictions == 2 && m.entries == 3);
+
+    cache_delete(c);
+}
+
+static void test_random(void)
+{
+    struct cache *c;
+    // Value last cached for each key, and whether it may still be cached.
+    int values[500] = { 0 };
+    bool present[500] = { false };
+
+    assert(!cache_new(64, &c));
+    srand(1);
+
+    for (int n = 0; n < 200000; ++n) {
+        int k = rand() % 500;
+        char key[16];
+        char value[16];
+        size_t length;
+        const char *found;
+
+        snprintf(key, sizeof(key), "%d", k);
+        found = cache_get(c, key, strlen(key), &length);
+
+        // Found entries hold the value last cached; absent entries were evicted.
+        snprintf(value, sizeof(value), "%d", values[k]);
+        assert(!found || (present[k] && length == strlen(value) && !memcmp(found, value, length)));
+
+        if (!found) {
+            values[k] = n;
+            present[k] = true;
+            snprintf(value, sizeof(value), "%d", n);
+            assert(cache_put(c, key, strlen(key), value, strlen(value)));
+            assert(cached(c, key, value));
+        }
+    }
+
+    struct cache_metrics m;
+    cache_metrics(c, &m);
+    assert(m.entries == 64);
+    // Each miss is cached, and found at once.
+    assert(m.hits == 200000 && m.evictions == m.misses - 64);
+
+    cache_delete(c);
+}
+
+int main(void)
+{
+    test_new();
+    test_get();
+    test_clock();
+    test_random();
+}
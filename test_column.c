@@ -0,0 +1,96 @@
+#include "column.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/// Fuzzy compare.
+static bool fcmp(double x, double y)
+{
+    return fabs(x - y) < 0.000001;
+}
+
+/// Number of values in test column; not a multiple of the block size or vector width.
+#define LENGTH 10007
+
+static double values_[LENGTH];
+static uint8_t validity_[(LENGTH + 7) / 8];
+
+static void test_unit(void)
+{
+    enum unit unit;
+
+    assert(!column_unit(L"mm", &unit));
+    assert(unit == PresentationUnitMillimetre);
+    assert(!column_unit(L"long tons", &unit));
+    assert(unit == PresentationUnitLongTon);
+    assert(-EINVAL == column_unit(L"", &unit));
+    assert(-EINVAL == column_unit(L"@", &unit));
+    assert(-EINVAL == column_unit(L"mm2", &unit));
+}
+
+/// Verify conversion of test column from inches to millimetres with @c threads.
+static void verify(const struct column *column, unsigned threads)
+{
+    static double out[LENGTH];
+
+    assert(!column_convert(column, PresentationUnitMillimetre, out, threads));
+
+    for (size_t i = 0; i < LENGTH; ++i) {
+        if (!column->validity || (column->validity[i / 8] >> (i % 8)) & 1) {
+            assert(fcmp(values_[i] * 25.4, out[i]));
+        } else {
+            assert(values_[i] == out[i]);
+        }
+    }
+}
+
+static void test_convert(void)
+{
+    struct column column = { values_, validity_, LENGTH, PresentationUnitInch };
+    double in_place[LENGTH];
+
+    for (size_t i = 0; i < LENGTH; ++i) {
+        values_[i] = (double)i / 4;
+        // Every third value is null.
+        validity_[i / 8] |= (uint8_t)((i % 3 != 0) << (i % 8));
+    }
+
+    verify(&column, 1);
+    verify(&column, 3);
+    verify(&column, 0);
+    verify(&column, 1000);
+
+    column.validity = NULL;
+    verify(&column, 2);
+
+    // In place.
+    for (size_t i = 0; i < LENGTH; ++i) {
+        in_place[i] = values_[i];
+    }
+    column.values = in_place;
+    column.unit = PresentationUnitDegreesFahrenheit;
+    assert(!column_convert(&column, PresentationUnitDegreesCelsius, in_place, 4));
+    assert(fcmp(-17.777777, in_place[0]));
+    assert(fcmp(-17.5, in_place[2]));
+
+    // Incompatible.
+    assert(-EPERM == column_convert(&column, PresentationUnitKilogram, in_place, 4));
+
+    // Empty.
+    column.values = NULL;
+    column.length = 0;
+    assert(!column_convert(&column, PresentationUnitDegreesCelsius, NULL, 4));
+}
+
+int main(void)
+{
+    // This file is encoded as UTF-8.
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    test_unit();
+    test_convert();
+}
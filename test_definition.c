@@ -0,0 +1,380 @@
+#include "definition.h"
+#include "label.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Fuzzy compare.
+static bool fcmp(double x, double y)
+{
+    return fabs(x - y) < 0.000001;
+}
+
+/// Scratch directory.
+static char dir_[] = "/tmp/test_definition.XXXXXX";
+/// Definitions file.
+static char path_[sizeof(dir_) + 16];
+/// Cache file.
+static char cache_[sizeof(path_) + 16];
+
+/// Write @c text to file at @c path.
+static void put(const char *path, const char *text)
+{
+    FILE *f = fopen(path, "w");
+    assert(f);
+    fputs(text, f);
+    fclose(f);
+}
+
+/// Load definitions @c text.
+/// @return Result of definitions_load, with @c line updated.
+static int load(const char *text, size_t *line)
+{
+    struct definitions *defs;
+    int r;
+
+    unlink(cache_);
+    put(path_, text);
+    r = definitions_load(path_, &defs, line);
+    assert(!r == !!defs);
+    definitions_delete(defs);
+    return r;
+}
+
+/// Verify that @c text is malformed on @c line.
+static void malformed(const char *text, size_t line)
+{
+    size_t actual;
+    assert(-EINVAL == load(text, &actual));
+    assert(line == actual);
+}
+
+/// @return Unit of @c label.
+static enum unit lookup(wchar_t *label)
+{
+    wchar_t *p;
+    enum unit unit = label_lookup(label, &p);
+    assert(!*p || unit == PresentationUnitUnknown);
+    return unit;
+}
+
+/// Verify converting @c quantity from unit @c from to unit @c to.
+static void convert(double quantity, wchar_t *from, wchar_t *to, double expected)
+{
+    enum base base;
+    double actual;
+    double q = unit_to_base(quantity, lookup(from), &base);
+    assert(!base_to_unit(q, base, lookup(to), &actual));
+    assert(fcmp(expected, actual));
+}
+
+static const char Text[] =
+    "# Flow rate.\n"
+    "unit\tL/min\tm^3\t1.6666666666666667E-5\n"
+    "label\tlitres per minute\tL/min\n"
+    "label\tlpm\tL/min\n"
+    "\n"
+    "# Data size.\n"
+    "base\tB\n"
+    "unit\tbit\tB\t0.125\n"
+    "unit\tkB\tB\t1000\n"
+    "label\tkilobyte\tkB\n"
+    "label\tmetres of\tm\n"
+    "label\tyd\tm\n"
+    "# Temperature.\n"
+    "unit\t°Ré\tK\t1.25\t218.52\n";
+
+static void test_load(void)
+{
+    struct definitions *defs;
+    struct definitions *again;
+    const struct extension *ext;
+    struct stat st;
+    size_t line;
+
+    unlink(cache_);
+    put(path_, Text);
+    assert(!chmod(path_, 0755));
+
+    // The cache has the mode of the definitions, less execution.
+    assert(!definitions_load(path_, &defs, &line));
+    assert(!stat(cache_, &st));
+    assert((st.st_mode & 0777) == 0644);
+
+    ext = definitions_extension(defs);
+    assert(ext->bases == 1);
+    assert(ext->units == 4);
+    assert(ext->labels == 9);
+
+    assert(lookup(L"lpm") == PresentationUnitUnknown);
+    extension_set(ext);
+
+    assert(lookup(L"L/min") == PresentationUnitCount);
+    assert(lookup(L"lpm") == PresentationUnitCount);
+    assert(lookup(L"litres per minute") == PresentationUnitCount);
+    assert(lookup(L"litres") == PresentationUnitUnknown);
+    assert(lookup(L"kilobyte") == PresentationUnitCount + 2);
+    assert(lookup(L"metres of") == PresentationUnitMetre);
+    // Defined labels win unless a built-in label is longer.
+    assert(lookup(L"m") == PresentationUnitMetre);
+    assert(lookup(L"metres") == PresentationUnitMetre);
+    assert(lookup(L"yd") == PresentationUnitMetre);
+    assert(lookup(L"yds") == PresentationUnitYard);
+    assert(!wcscmp(symbol_of_unit(PresentationUnitCount + 3), L"°Ré"));
+
+    convert(1, L"L/min", L"ml", 16.666666);
+    convert(8, L"bit", L"kB", 0.001);
+    convert(0, L"°Ré", L"°C", 0);
+    convert(80, L"°Ré", L"°C", 100);
+
+    enum base base;
+    unit_to_base(1, PresentationUnitCount + 1, &base);
+    assert(base == BaseUnitCount);
+    assert(-EPERM == base_to_unit(1, base, PresentationUnitMetre, NULL));
+
+    label_synonyms(PresentationUnitCount);
+    label_synonyms(PresentationUnitMetre);
+
+    // Cache is current.
+    assert(!definitions_load(path_, &again, &line));
+    assert(definitions_extension(again)->units == 4);
+    assert(definitions_size(again) == definitions_size(defs));
+    assert(!wcscmp(symbol_of_unit(PresentationUnitCount + 3), L"°Ré"));
+    definitions_delete(again);
+
+    // Cache is stale.
+    put(path_, "unit\tfur\tm\t201.168\n");
+    assert(!definitions_load(path_, &again, &line));
+    assert(definitions_extension(again)->units == 1);
+    extension_set(definitions_extension(again));
+    assert(lookup(L"fur") == PresentationUnitCount);
+    assert(lookup(L"lpm") == PresentationUnitUnknown);
+    definitions_delete(again);
+
+    extension_set(NULL);
+    definitions_delete(defs);
+    definitions_delete(NULL);
+}
+
+static void test_cache(void)
+{
+    struct definitions *defs;
+    size_t line;
+
+    // Corrupt cache.
+    put(path_, Text);
+    put(cache_, "garbage");
+    assert(!definitions_load(path_, &defs, &line));
+    assert(definitions_extension(defs)->units == 4);
+    definitions_delete(defs);
+
+    // Empty cache.
+    put(cache_, "");
+    assert(!definitions_load(path_, &defs, &line));
+    definitions_delete(defs);
+
+    // Cache cannot be written.
+    unlink(cache_);
+    assert(!mkdir(cache_, 0700));
+    assert(!definitions_load(path_, &defs, &line));
+    assert(definitions_extension(defs)->units == 4);
+    definitions_delete(defs);
+    assert(!rmdir(cache_));
+}
+
+static void test_replace(void)
+{
+    struct definitions *defs;
+    const struct extension *ext;
+    struct unit_conversion c;
+    struct unit_conversion_fixed f;
+    enum unit units[32];
+    size_t n;
+    size_t line;
+    int64_t x;
+
+    unlink(cache_);
+    put(path_, "unit\ttn\tkg\t907.18474\nlabel\tstn\ttn\n");
+    assert(!definitions_load(path_, &defs, &line));
+    ext = definitions_extension(defs);
+    assert(ext->units == 1 && ext->replaces[0] == PresentationUnitShortTon);
+    extension_set(ext);
+
+    // Labels of the built-in unit, and labels defined for it, refer to the replacement.
+    assert(lookup(L"tn") == PresentationUnitShortTon);
+    assert(lookup(L"stn") == PresentationUnitShortTon);
+    assert(!wcscmp(symbol_of_unit(PresentationUnitShortTon), L"tn"));
+    assert(!wcscmp(symbol_of_unit(PresentationUnitCount), L"tn"));
+    convert(1, L"tn", L"kg", 907.18474);
+    convert(2, L"short tons", L"kg", 1814.36948);
+    convert(907.18474, L"kg", L"stn", 1);
+
+    assert(!unit_conversion(PresentationUnitShortTon, PresentationUnitKilogram, &c));
+    assert(!c.exact && fcmp(unit_convert(&c, 1), 907.18474));
+    assert(!unit_conversion_fixed(PresentationUnitShortTon, 0, PresentationUnitKilogram, 0, &f));
+    assert(!unit_convert_fixed(&f, 100000, &x) && x == 90718474);
+
+    // The replacement is listed as the built-in unit.
+    n = base_units(BaseUnitKilogram, units, sizeof(units) / sizeof(*units));
+    for (size_t i = 0; i < n; ++i) {
+        assert(units[i] < PresentationUnitCount);
+    }
+    assert(n == base_units(BaseUnitKilogram, NULL, 0));
+
+    extension_set(NULL);
+    convert(1, L"tn", L"kg", 907.1847);
+    definitions_delete(defs);
+
+    // A defined label replaces a built-in label.
+    put(path_, "label\ttn\tkg\n");
+    assert(!definitions_load(path_, &defs, &line));
+    extension_set(definitions_extension(defs));
+    assert(lookup(L"tn") == PresentationUnitKilogram);
+    assert(lookup(L"short ton") == PresentationUnitShortTon);
+    extension_set(NULL);
+    definitions_delete(defs);
+}
+
+/// Read file at @c path into @c buffer of @c size bytes.
+/// @return True if the file has exactly @c size bytes.
+static bool get(const char *path, char *buffer, size_t size)
+{
+    FILE *f = fopen(path, "r");
+    size_t n;
+
+    assert(f);
+    n = fread(buffer, 1, size, f);
+    n += fgetc(f) != EOF;
+    fclose(f);
+    return n == size;
+}
+
+/// Write @c size bytes of @c buffer to file at @c path.
+static void set(const char *path, const char *buffer, size_t size)
+{
+    FILE *f = fopen(path, "w");
+    assert(f && fwrite(buffer, 1, size, f) == size);
+    fclose(f);
+}
+
+static void test_hostile(void)
+{
+    struct definitions *defs;
+    struct stat st;
+    size_t line;
+    size_t rejected = 0;
+
+    put(path_, "base\tB\nunit\tkB\tB\t1000\nunit\ttn\tkg\t907.18474\nlabel\tshort\ttn\nlabel\tkilobyte\tkB\n");
+    unlink(cache_);
+    assert(!definitions_load(path_, &defs, &line));
+    definitions_delete(defs);
+    assert(!stat(cache_, &st));
+
+    size_t size = (size_t)st.st_size;
+    char *image = malloc(size);
+    char *copy = malloc(size);
+    assert(image && copy && get(cache_, image, size));
+
+    // Corrupt each word of the cache in turn: it is either rejected and rebuilt, or safe to use.
+    for (size_t i = 0; i + 4 <= size; i += 4) {
+        const struct extension *ext;
+        wchar_t *p;
+        enum base base;
+
+        memcpy(copy, image, size);
+        memset(copy + i, 0xff, 4);
+        set(cache_, copy, size);
+
+        assert(!definitions_load(path_, &defs, &line));
+        ext = definitions_extension(defs);
+        extension_set(ext);
+        label_lookup(L"kilobyte", &p);
+        label_lookup(L"short", &p);
+        symbol_of_unit(PresentationUnitShortTon);
+        unit_to_base(1, PresentationUnitShortTon, &base);
+        for (uint32_t u = 0; u < ext->units; ++u) {
+            symbol_of_unit((enum unit)(PresentationUnitCount + u));
+            unit_to_base(1, (enum unit)(PresentationUnitCount + u), &base);
+        }
+        extension_set(NULL);
+        definitions_delete(defs);
+
+        rejected += get(cache_, copy, size) && !memcmp(copy, image, size);
+    }
+
+    // The header, the terminator of the last string, and indices at least.
+    assert(rejected > 16);
+    memset(image + size - sizeof(wchar_t), 0xff, sizeof(wchar_t));
+    set(cache_, image, size);
+    assert(!definitions_load(path_, &defs, &line));
+    definitions_delete(defs);
+    assert(get(cache_, copy, size) && memcmp(copy, image, size));
+
+    free(image);
+    free(copy);
+}
+
+static void test_errors(void)
+{
+    struct definitions *defs;
+    size_t line;
+
+    assert(-ENOENT == definitions_load("/nonexistent", &defs, &line));
+    assert(!defs);
+    assert(-EIO == definitions_load(dir_, &defs, &line));
+    assert(-EILSEQ == load("unit\t\xff\tm\t1\n", &line));
+
+    assert(!load("", &line));
+    assert(!load("# Comment.\n\n", &line));
+
+    malformed("foo\n", 1);
+    malformed("\nbase\n", 2);
+    malformed("base\t\n", 1);
+    malformed("base\tm\n", 1);
+    malformed("base\tB\nbase\tB\n", 2);
+    malformed("unit\tfoo\tm\n", 1);
+    malformed("unit\t\tm\t1\n", 1);
+    malformed("unit\tm\tkg\t1\n", 1);
+    malformed("unit\ttn\tkg\t907\nunit\ttn\tkg\t907\n", 2);
+    malformed("unit\tfoo\tB\t1\n", 1);
+    malformed("unit\tfoo\tm\tx\n", 1);
+    malformed("unit\tfoo\tm\t1x\n", 1);
+    malformed("unit\tfoo\tm\t\n", 1);
+    malformed("unit\tfoo\tm\t0\n", 1);
+    malformed("unit\tfoo\tm\tinf\n", 1);
+    malformed("unit\tfoo\tm\t1\tx\n", 1);
+    malformed("unit\tfoo\tm\t1\nunit\tfoo\tm\t1\n", 2);
+    malformed("unit\tfoo\tm\t1\t2\t3\n", 1);
+    malformed("unit\tfoo\tm\t1\t2\t3\t4\t5\n", 1);
+    malformed("label\tfoo\n", 1);
+    malformed("label\tfoo\tbaz\n", 1);
+    malformed("label\t\tm\n", 1);
+}
+
+int main(void)
+{
+    // This file is encoded as UTF-8.
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    assert(mkdtemp(dir_));
+    snprintf(path_, sizeof(path_), "%s/defs", dir_);
+    snprintf(cache_, sizeof(cache_), "%s.cache", path_);
+
+    test_load();
+    test_cache();
+    test_replace();
+    test_hostile();
+    test_errors();
+
+    unlink(cache_);
+    unlink(path_);
+    rmdir(dir_);
+}
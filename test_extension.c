@@ -0,0 +1,360 @@
+#include "definition.h"
+#include "extension.h"
+#include "label.h"
+#include "reload.h"
+
+#include <assert.h>
+#include <locale.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/// Number of reading threads.
+#define THREADS 64
+
+/// Number of extensions installed while they read.
+#define RELOADS 50
+
+/// Extension defining unit "fur", with tables allocated together so that use after release is detected.
+struct generation {
+    struct extension ext;
+    uint32_t symbol[1];
+    int32_t base[1];
+    double scale[1];
+    double offset[1];
+    struct extension_label label[1];
+    struct extension_node node[4];
+    wchar_t strings[4];
+};
+
+/// @return Extension in which "fur" has scale @c scale.
+static struct generation *generation(double scale)
+{
+    struct generation *g = calloc(1, sizeof(*g));
+
+    assert(g);
+    g->base[0] = BaseUnitMetre;
+    g->scale[0] = scale;
+    g->label[0] = (struct extension_label){ 0, PresentationUnitCount };
+    g->node[0] = (struct extension_node){ 0, 1, 0, PresentationUnitNone };
+    g->node[1] = (struct extension_node){ L'f', 2, 0, PresentationUnitNone };
+    g->node[2] = (struct extension_node){ L'u', 3, 0, PresentationUnitNone };
+    g->node[3] = (struct extension_node){ L'r', 0, 0, PresentationUnitCount };
+    wcscpy(g->strings, L"fur");
+    g->ext = (struct extension){
+        .units = 1, .labels = 1, .nodes = 4, .symbol = g->symbol, .base = g->base, .scale = g->scale,
+        .offset = g->offset, .label = g->label, .node = g->node, .strings = g->strings
+    };
+    return g;
+}
+
+static void test_nested(void)
+{
+    struct generation *a = generation(1);
+    struct generation *b = generation(2);
+
+    extension_set(&a->ext);
+    assert(&a->ext == extension_get());
+
+    assert(!extension_enter());
+    uint64_t epoch = extension_epoch();
+    assert(!extension_enter());
+    extension_set(&b->ext);
+    assert(&a->ext == extension_get());
+    extension_leave();
+    assert(&a->ext == extension_get());
+    extension_leave();
+    assert(&b->ext == extension_get());
+
+    extension_set(NULL);
+    extension_synchronize();
+
+    // The epoch advances before a replaced extension is released.
+    assert(!extension_enter());
+    assert(extension_epoch() > epoch);
+    extension_leave();
+    free(a);
+    free(b);
+}
+
+/// Outside a section.
+static void *idle(void *arg)
+{
+    (void)arg;
+    extension_leave();
+    assert(!extension_epoch());
+    return NULL;
+}
+
+static void test_idle(void)
+{
+    pthread_t thread;
+
+    // In a thread that has never read.
+    assert(!pthread_create(&thread, NULL, idle, NULL));
+    assert(!pthread_join(thread, NULL));
+
+    // In a thread that has read.
+    assert(!extension_enter());
+    extension_leave();
+    idle(NULL);
+}
+
+static atomic_bool entered;
+static atomic_bool leaving;
+
+/// Read for a while.
+static void *hold(void *arg)
+{
+    (void)arg;
+    assert(!extension_enter());
+    atomic_store(&entered, true);
+    usleep(20000);
+    atomic_store(&leaving, true);
+    extension_leave();
+    return NULL;
+}
+
+static void test_synchronize(void)
+{
+    struct generation *a = generation(1);
+    pthread_t thread;
+
+    extension_set(&a->ext);
+    assert(!pthread_create(&thread, NULL, hold, NULL));
+    while (!atomic_load(&entered)) {
+        usleep(1000);
+    }
+
+    // Waits for the reader, which may still see @c a.
+    extension_set(NULL);
+    extension_synchronize();
+    assert(atomic_load(&leaving));
+    free(a);
+
+    assert(!pthread_join(thread, NULL));
+}
+
+/// Exit inside nested sections.
+static void *abandon(void *arg)
+{
+    (void)arg;
+    assert(!extension_enter());
+    assert(!extension_enter());
+    return NULL;
+}
+
+/// Read in a thread that may reuse the record of an exited one.
+static void *reuse(void *arg)
+{
+    assert(!extension_enter());
+    assert(extension_get() == arg);
+    extension_leave();
+    assert(!extension_epoch());
+    return NULL;
+}
+
+static void test_exit(void)
+{
+    struct generation *a = generation(1);
+    struct generation *b = generation(2);
+    pthread_t thread;
+
+    extension_set(&a->ext);
+    assert(!pthread_create(&thread, NULL, abandon, NULL));
+    assert(!pthread_join(thread, NULL));
+
+    // Does not wait for the exited thread.
+    extension_set(&b->ext);
+    extension_synchronize();
+    free(a);
+
+    // The next owner of its record pins the current extension.
+    assert(!pthread_create(&thread, NULL, reuse, &b->ext));
+    assert(!pthread_join(thread, NULL));
+    extension_set(NULL);
+    free(b);
+}
+
+/// Definitions file.
+static char path_[] = "/tmp/test_extension.XXXXXX";
+/// Cache file.
+static char cache_[sizeof(path_) + 8];
+
+/// Write definitions of unit "fur" with @c scale.
+static void define(const char *scale)
+{
+    FILE *f = fopen(path_, "w");
+
+    assert(f);
+    fprintf(f, "unit\tfur\tm\t%s\n", scale);
+    fclose(f);
+    unlink(cache_);
+}
+
+/// @return Quantity of 1 fur in metres.
+static double fur(void)
+{
+    wchar_t label[] = L"fur";
+    wchar_t *p;
+    enum base base;
+
+    return unit_to_base(1, label_lookup(label, &p), &base);
+}
+
+static atomic_bool pinned;
+
+/// Read in a section that spans a reload, which sees the same definitions and epoch throughout.
+static void *pin(void *arg)
+{
+    (void)arg;
+    assert(!extension_enter());
+
+    const struct extension *ext = extension_get();
+    uint64_t epoch = extension_epoch();
+
+    assert(1 == fur());
+    atomic_store(&pinned, true);
+    usleep(20000);
+    assert(ext == extension_get() && epoch == extension_epoch());
+    assert(1 == fur());
+    extension_leave();
+    return NULL;
+}
+
+static void test_definitions(void)
+{
+    struct definitions *defs;
+    pthread_t thread;
+    uint64_t epoch;
+    size_t line;
+    int fd = mkstemp(path_);
+
+    assert(fd >= 0);
+    close(fd);
+    snprintf(cache_, sizeof(cache_), "%s.cache", path_);
+
+    // Definitions installed directly, then replaced by reload.
+    define("1");
+    assert(!definitions_load(path_, &defs, &line));
+    extension_set(definitions_extension(defs));
+    assert(!pthread_create(&thread, NULL, pin, NULL));
+    while (!atomic_load(&pinned)) {
+        usleep(1000);
+    }
+
+    define("201.168");
+    assert(!extension_enter());
+    epoch = extension_epoch();
+    extension_leave();
+    assert(!reload(path_, &line));
+
+    // The reader has left, so the first definitions may be released.
+    assert(!pthread_join(thread, NULL));
+    definitions_delete(defs);
+
+    assert(!extension_enter());
+    assert(extension_get() != NULL && extension_epoch() > epoch);
+    assert(201.168 == fur());
+    extension_leave();
+
+    reload_release();
+    assert(!extension_get());
+
+    unlink(cache_);
+    unlink(path_);
+}
+
+static atomic_bool done;
+static atomic_size_t lookups;
+
+/// Look up unit "fur" until done, checking that each lookup sees one extension throughout.
+static void *look_up(void *arg)
+{
+    (void)arg;
+
+    while (!atomic_load(&done)) {
+        wchar_t fur[] = L"fur";
+        wchar_t *p;
+        enum base base;
+
+        assert(!extension_enter());
+
+        const struct extension *ext = extension_get();
+        enum unit unit = label_lookup(fur, &p);
+        double scale = unit_to_base(1, unit, &base);
+
+        if (ext) {
+            assert(PresentationUnitCount == unit);
+            assert(BaseUnitMetre == base);
+            assert(ext->scale[0] == scale);
+            assert(!wcscmp(symbol_of_unit(unit), L"fur"));
+        } else {
+            assert(PresentationUnitUnknown == unit);
+        }
+
+        extension_leave();
+        atomic_fetch_add(&lookups, 1);
+    }
+
+    return NULL;
+}
+
+static void test_stress(void)
+{
+    struct generation *previous = NULL;
+    pthread_t threads[THREADS];
+
+    for (size_t t = 0; t < THREADS; ++t) {
+        assert(!pthread_create(&threads[t], NULL, look_up, NULL));
+    }
+
+    for (int i = 1; i <= RELOADS; ++i) {
+        struct generation *g = i % 10 ? generation(i) : NULL;
+
+        extension_set(g ? &g->ext : NULL);
+        extension_synchronize();
+
+        // No thread can still read the previous extension.
+        if (previous) {
+            memset(previous, 0xff, sizeof(*previous));
+        }
+        free(previous);
+        previous = g;
+    }
+
+    atomic_store(&done, true);
+    for (size_t t = 0; t < THREADS; ++t) {
+        assert(!pthread_join(threads[t], NULL));
+    }
+
+    assert(atomic_load(&lookups) > 0);
+    extension_set(NULL);
+    free(previous);
+
+    // Records of exited threads are reused.
+    atomic_store(&done, false);
+    atomic_store(&lookups, 0);
+    assert(!pthread_create(&threads[0], NULL, look_up, NULL));
+    while (!atomic_load(&lookups)) {
+        usleep(1000);
+    }
+    atomic_store(&done, true);
+    assert(!pthread_join(threads[0], NULL));
+}
+
+int main(void)
+{
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    test_nested();
+    test_idle();
+    test_synchronize();
+    test_exit();
+    test_definitions();
+    test_stress();
+}
@@ -0,0 +1,223 @@
+#include "extract.h"
+#include "extension.h"
+
+#include <assert.h>
+#include <locale.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+/// Fuzzy compare.
+static bool fcmp(double x, double y)
+{
+    return x == y || fabs(x - y) <= 0.000001 * fmax(1, fabs(y));
+}
+
+static struct extractor *extractor_;
+
+/// Verify that the first quantity in @c text is @c value of @c unit at @c match.
+static void find(const char *text, const char *match, enum unit unit, double value)
+{
+    struct extract_match m;
+    size_t offset = 0;
+
+    assert(extractor_find(extractor_, text, strlen(text), &offset, &m));
+    assert(m.end - m.begin == strlen(match) && !memcmp(text + m.begin, match, m.end - m.begin));
+    assert(offset == m.end);
+    assert(m.unit == unit);
+    assert(fcmp(m.value, value));
+}
+
+/// Verify that @c text has no quantity.
+static void none(const char *text)
+{
+    struct extract_match m;
+    size_t offset = 0;
+
+    assert(!extractor_find(extractor_, text, strlen(text), &offset, &m));
+    assert(offset == strlen(text));
+}
+
+static void test_number(void)
+{
+    find("5 m", "5 m", PresentationUnitMetre, 5);
+    find("0.25 m", "0.25 m", PresentationUnitMetre, 0.25);
+    find("x .5 kg", ".5 kg", PresentationUnitKilogram, 0.5);
+    find("(-.5 kg)", "-.5 kg", PresentationUnitKilogram, -0.5);
+    find("+2 kg", "+2 kg", PresentationUnitKilogram, 2);
+    find("5-10 m", "10 m", PresentationUnitMetre, 10);
+    find("1e3 m", "1e3 m", PresentationUnitMetre, 1000);
+    find("1E+2 m", "1E+2 m", PresentationUnitMetre, 100);
+    find("25e-3 m", "25e-3 m", PresentationUnitMetre, 0.025);
+    find("1e30 m", "1e30 m", PresentationUnitMetre, 1e30);
+    find("1e99999 m", "1e99999 m", PresentationUnitMetre, INFINITY);
+    find("12345678901234567890123 m", "12345678901234567890123 m", PresentationUnitMetre, 1.2345678901234568e22);
+    find("0.12345678901234567890123 m", "0.12345678901234567890123 m", PresentationUnitMetre, 0.12345678901234568);
+    find("0.000001 m", "0.000001 m", PresentationUnitMetre, 0.000001);
+
+    // Grouped thousands.
+    find("1,200 lb", "1,200 lb", PresentationUnitPound, 1200);
+    find("1,234,567.5 m", "1,234,567.5 m", PresentationUnitMetre, 1234567.5);
+    find("12,345,678 m", "12,345,678 m", PresentationUnitMetre, 12345678);
+    none("1,000,0 m");
+
+    // Not a number, or part of a word or another number.
+    none("");
+    none("m");
+    none("x5 m");
+    none("x.5 m");
+    none("1..5 m");
+    none("1,5 m");
+    none("12,34 m");
+    none("1234,567 m");
+    none("1,2345 m");
+    none("1/2\"");
+    none("5em");
+    none("5e+ m");
+    none("5");
+    none("5 ");
+}
+
+static void test_label(void)
+{
+    find("3miles", "3miles", PresentationUnitMile, 3);
+    find("20°C", "20°C", PresentationUnitDegreesCelsius, 20);
+    find("-40 °F", "-40 °F", PresentationUnitDegreesFahrenheit, -40);
+    find("90°N", "90°", PresentationUnitDegree, 90);
+    find("5\tkg", "5\tkg", PresentationUnitKilogram, 5);
+    find("5\xc2\xa0kg", "5\xc2\xa0kg", PresentationUnitKilogram, 5);
+    find("5 square feet.", "5 square feet", PresentationUnitSquareFoot, 5);
+
+    none("3 mx");
+    none("5 m2");
+    none("3 \xc2");
+    none("5 kgs");
+    none("5 Kg");
+
+    // Labels that are also words, followed by a word.
+    none("Replaced 5 in 10 bolts");
+    none("the 21st century");
+    none("5 t and");
+    find("5 in.", "5 in", PresentationUnitInch, 5);
+    find("5 in", "5 in", PresentationUnitInch, 5);
+    find("10 stone, 5 m", "10 stone", PresentationUnitStone, 10);
+}
+
+static void test_compound(void)
+{
+    find("He is 6'3\" tall", "6'3\"", PresentationUnitFeet, 6.25);
+    find("5 ft 3 in", "5 ft 3 in", PresentationUnitFeet, 5.25);
+    find("-5 ft 3 in", "-5 ft 3 in", PresentationUnitFeet, -5.25);
+    find("7 lb 14 oz", "7 lb 14 oz", PresentationUnitPound, 7.875);
+    find("1 ° 30 arcmin 36 arcsec", "1 ° 30 arcmin 36 arcsec", PresentationUnitDegree, 1.51);
+    find("5 ft 3", "5 ft", PresentationUnitFeet, 5);
+    find("5 ft in", "5 ft", PresentationUnitFeet, 5);
+    find("5 ft 3 kg", "5 ft", PresentationUnitFeet, 5);
+    find("5 ft 3 x", "5 ft", PresentationUnitFeet, 5);
+    find("5 ft ", "5 ft", PresentationUnitFeet, 5);
+    find("5 ft 3 in of pipe", "5 ft 3 in", PresentationUnitFeet, 5.25);
+}
+
+/// Verify that the first quantity in @c text is @c match, with tolerance @c tolerance of its value.
+static void tolerance(const char *text, const char *match, double tolerance)
+{
+    struct extract_match m;
+    size_t offset = 0;
+
+    assert(extractor_find(extractor_, text, strlen(text), &offset, &m));
+    assert(m.end - m.begin == strlen(match) && !memcmp(text + m.begin, match, m.end - m.begin));
+    assert(fcmp(m.value_tolerance, tolerance));
+}
+
+static void test_tolerance(void)
+{
+    struct extract_match m;
+    size_t offset = 0;
+
+    tolerance("12.5 ± 0.1 mm", "12.5 ± 0.1 mm", 0.1);
+    tolerance("20+/-0.5°C", "20+/-0.5°C", 0.5);
+    tolerance("-3 ±2 kg", "-3 ±2 kg", 2);
+    tolerance("5 m", "5 m", 0);
+
+    // The tolerance of an affine unit is converted without offset.
+    assert(extractor_find(extractor_, "20 ± 0.5 °C", strlen("20 ± 0.5 °C"), &offset, &m));
+    assert(fcmp(m.value, 20) && fcmp(m.quantity, 293.15) && fcmp(m.tolerance, 0.5));
+
+    // Without a label, or with lesser parts, the quantity and its tolerance are skipped.
+    none("12.5 ± 0.1");
+    none("12.5 ± 0.1 x");
+    none("5 ± 1 ft 3 in");
+    find("5 ± 1 ft 3 in of 2 m", "2 m", PresentationUnitMetre, 2);
+
+    // A sign without a tolerance.
+    none("12.5 ± mm");
+}
+
+static void test_offset(void)
+{
+    const char *text = "Add 2 kg of flour, 500 g of sugar and 3 eggs to 1 L of milk.";
+    struct extract_match m;
+    size_t offset = 0;
+
+    assert(extractor_find(extractor_, text, strlen(text), &offset, &m));
+    assert(m.begin == 4 && m.unit == PresentationUnitKilogram && m.base == BaseUnitKilogram && fcmp(m.quantity, 2));
+    assert(extractor_find(extractor_, text, strlen(text), &offset, &m));
+    assert(m.begin == 19 && m.unit == PresentationUnitGram && fcmp(m.quantity, 0.5));
+    assert(extractor_find(extractor_, text, strlen(text), &offset, &m));
+    assert(m.unit == PresentationUnitLitre && m.base == BaseUnitCubicMetre && fcmp(m.quantity, 0.001));
+    assert(!extractor_find(extractor_, text, strlen(text), &offset, &m));
+    assert(offset == strlen(text));
+}
+
+static void test_extension(void)
+{
+    static const uint32_t symbol[] = { 0 };
+    static const int32_t base[] = { BaseUnitMetre };
+    static const double scale[] = { 201.168 };
+    static const double offset[] = { 0 };
+    static const struct extension_label label[] = {
+        { 0, PresentationUnitCount }, { 4, PresentationUnitCount }, { 6, PresentationUnitCount },
+        { 8, PresentationUnitCount }
+    };
+    static const struct extension ext = {
+        .units = 1, .labels = 4, .symbol = symbol, .base = base, .scale = scale, .offset = offset, .label = label,
+        .strings = L"fur\0m\0″\0\U0001F4CF"
+    };
+
+    extension_set(&ext);
+    extractor_delete(extractor_);
+    extractor_ = extractor_new();
+    assert(extractor_);
+
+    find("a 2 fur race", "2 fur", PresentationUnitCount, 2);
+    find("2″", "2″", PresentationUnitCount, 2);
+    find("2 \U0001F4CF", "2 \U0001F4CF", PresentationUnitCount, 2);
+    // A defined label takes precedence.
+    find("2 m", "2 m", PresentationUnitCount, 2);
+
+    struct extract_match m;
+    size_t at = 0;
+    assert(extractor_find(extractor_, "1 fur", 5, &at, &m));
+    assert(m.base == BaseUnitMetre && fcmp(m.quantity, 201.168));
+
+    extension_set(NULL);
+}
+
+int main(void)
+{
+    // This file is encoded as UTF-8.
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    extractor_ = extractor_new();
+    assert(extractor_);
+
+    test_number();
+    test_label();
+    test_compound();
+    test_tolerance();
+    test_offset();
+    test_extension();
+
+    extractor_delete(extractor_);
+    extractor_delete(NULL);
+}
@@ -0,0 +1,138 @@
+#include "label.h"
+#include "extension.h"
+
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/// Verify that @c s is parsed as @c unit with @c tail remaining.
+static void lookup(wchar_t *s, enum unit unit, const wchar_t *tail)
+{
+    wchar_t *p;
+    assert(unit == label_lookup(s, &p));
+    assert(!wcscmp(p, tail));
+}
+
+/// Verify that @c s is parsed tolerantly as @c unit with @c tail remaining.
+static void tolerant(wchar_t *s, enum unit unit, const wchar_t *tail)
+{
+    wchar_t *p;
+    assert(unit == label_lookup_tolerant(s, &p));
+    assert(!wcscmp(p, tail));
+}
+
+/// Verify that the suggestion for @c s is @c expected.
+static void suggest(const wchar_t *s, const wchar_t *expected)
+{
+    const wchar_t *actual = label_suggest(s);
+
+    if (expected) {
+        assert(actual && !wcscmp(actual, expected));
+    } else {
+        assert(!actual);
+    }
+}
+
+static void test_lookup(void)
+{
+    lookup(L"", PresentationUnitNone, L"");
+    lookup(L"@", PresentationUnitUnknown, L"@");
+    lookup(L"m", PresentationUnitMetre, L"");
+    lookup(L"mm", PresentationUnitMillimetre, L"");
+    lookup(L"m2", PresentationUnitMetre, L"2");
+    lookup(L"m^2", PresentationUnitSquareMetre, L"");
+    lookup(L"metres of", PresentationUnitMetre, L" of");
+    lookup(L"long tons", PresentationUnitLongTon, L"");
+    lookup(L"KG", PresentationUnitUnknown, L"KG");
+
+    label_synonyms(PresentationUnitMetre);
+    label_synonyms(PresentationUnitNone);
+}
+
+static void test_tolerant(void)
+{
+    tolerant(L"", PresentationUnitNone, L"");
+    tolerant(L"@", PresentationUnitUnknown, L"@");
+    tolerant(L"kg", PresentationUnitKilogram, L"");
+    tolerant(L"KG", PresentationUnitKilogram, L"");
+    tolerant(L"Kilograms", PresentationUnitKilogram, L"");
+    tolerant(L"Kilograms 2", PresentationUnitKilogram, L" 2");
+    tolerant(L"degree celsius", PresentationUnitDegreesCelsius, L"");
+    tolerant(L"DEGREES   FAHRENHEIT", PresentationUnitDegreesFahrenheit, L"");
+    tolerant(L"degrees\tfahrenheit", PresentationUnitDegreesFahrenheit, L"");
+    tolerant(L"degreesfahrenheit", PresentationUnitUnknown, L"degreesfahrenheit");
+    tolerant(L"DEGREE", PresentationUnitDegree, L"");
+    tolerant(L"ºC", PresentationUnitDegreesCelsius, L"");
+    tolerant(L"˚F", PresentationUnitDegreesFahrenheit, L"");
+    tolerant(L"’", PresentationUnitFeet, L"");
+    tolerant(L"’”", PresentationUnitFeetAndInches, L"");
+    // Primes are labels of arcminutes and arcseconds, not variants of feet and inches.
+    tolerant(L"′", PresentationUnitArcminute, L"");
+    tolerant(L"″", PresentationUnitArcsecond, L"");
+    tolerant(L"”HG", PresentationUnitInchesMercury, L"");
+    tolerant(L"KGS", PresentationUnitUnknown, L"KGS");
+    // Labels with different conversions.
+    tolerant(L"MG", PresentationUnitUnknown, L"MG");
+    // Labels with the same conversion.
+    tolerant(L"ML", PresentationUnitMillilitre, L"");
+}
+
+static void test_suggest(void)
+{
+    suggest(L"", NULL);
+    suggest(L"@", NULL);
+    suggest(L"KG", L"kg");
+    suggest(L"kilogramz", L"kilogram");
+    suggest(L"Pascals", L"pascal");
+    suggest(L"degree celcius", L"degree Celsius");
+    suggest(L"xyzzy", NULL);
+}
+
+static void test_builtin(void)
+{
+    enum unit unit;
+    size_t i = 0;
+
+    assert(!wcscmp(label_builtin(0, &unit), L"mm") && unit == PresentationUnitMillimetre);
+    while (label_builtin(i, &unit)) {
+        assert(*label_builtin(i++, &unit));
+    }
+    assert(i > 100);
+}
+
+static void test_extension(void)
+{
+    static const struct extension_label label[] = { { 0, PresentationUnitCount } };
+    static const struct extension_node node[] = {
+        { 0, 4, 0, PresentationUnitNone },
+        { L'f', 2, 0, PresentationUnitNone },
+        { L'u', 3, 0, PresentationUnitNone },
+        { L'r', 0, 0, PresentationUnitCount },
+        { L'g', 0, 1, PresentationUnitNone },
+    };
+    static const struct extension ext = {
+        .labels = 1, .nodes = 5, .label = label, .node = node, .strings = L"fur"
+    };
+
+    extension_set(&ext);
+    lookup(L"fur", PresentationUnitCount, L"");
+    lookup(L"fur2", PresentationUnitCount, L"2");
+    lookup(L"furs", PresentationUnitUnknown, L"furs");
+    lookup(L"fx", PresentationUnitUnknown, L"fx");
+    lookup(L"m", PresentationUnitMetre, L"");
+    label_synonyms(PresentationUnitCount);
+    extension_set(NULL);
+}
+
+int main(void)
+{
+    // This file is encoded as UTF-8.
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    test_lookup();
+    test_tolerant();
+    test_suggest();
+    test_builtin();
+    test_extension();
+}
@@ -113,6 +113,7 @@ int main(void)
     add(PARSE_AGAIN, L"5ft8in");
     add(PARSE_COMPLETE, L"m");
     pass(5.666666, PresentationUnitFeet, PresentationUnitMetre, 1.7272);
+    assert(fcmp(5 + 8.0 / 12, data_.value));
 
     add(PARSE_AGAIN, L"5ft");
     add(PARSE_AGAIN, L"8in");
@@ -146,6 +147,7 @@ int main(void)
     add(PARSE_AGAIN, L"7lb14oz");
     add(PARSE_COMPLETE, L"kg");
     pass(7.875, PresentationUnitPound, PresentationUnitKilogram, 3.57204);
+    assert(7.875 == data_.value);
 
     add(PARSE_AGAIN, L"7lb");
     add(PARSE_AGAIN, L"14oz");
@@ -170,8 +172,133 @@ int main(void)
     add(PARSE_AGAIN, L"80.33°F");
     add(PARSE_COMPLETE, L"K");
     pass(80.33, PresentationUnitDegreesFahrenheit, PresentationUnitKelvin, 300);
+    assert(80.33 == data_.value);
 
     add(PARSE_AGAIN, L"7.5006157585mmHg");
     add(PARSE_COMPLETE, L"Pa");
     pass(7.5006157585, PresentationUnitMillimetreMercury, PresentationUnitPascal, 1000);
+
+    // Tolerant labels.
+    add(PARSE_UNKNOWN_UNIT, L"5KG");
+    assert(!wcscmp(L"KG", term_));
+
+    parser_tolerant(parser_, true);
+
+    add(PARSE_AGAIN, L"5KG");
+    add(PARSE_COMPLETE, L"G");
+    pass(5, PresentationUnitKilogram, PresentationUnitGram, 5000);
+
+    add(PARSE_AGAIN, L"7LBS");
+    add(PARSE_AGAIN, L"14OZ");
+    add(PARSE_COMPLETE, L"Kilograms");
+    pass(7.875, PresentationUnitPound, PresentationUnitKilogram, 3.57204);
+
+    add(PARSE_AGAIN, L"26.85");
+    add(PARSE_AGAIN, L"degree  celsius");
+    add(PARSE_COMPLETE, L"KELVIN");
+    pass(26.85, PresentationUnitDegreesCelsius, PresentationUnitKelvin, 300);
+
+    parser_tolerant(parser_, false);
+
+    // Reset.
+    add(PARSE_AGAIN, L"7");
+    add(PARSE_AGAIN, L"kg");
+    parser_reset(parser_);
+    add(PARSE_AGAIN, L"8");
+    add(PARSE_AGAIN, L"lb");
+    add(PARSE_COMPLETE, L"oz");
+    pass(8, PresentationUnitPound, PresentationUnitOunce, 128);
+
+    // Words separated by white space.
+    add(PARSE_AGAIN, L"7 lbs 14 oz");
+    add(PARSE_COMPLETE, L"kg");
+    pass(7.875, PresentationUnitPound, PresentationUnitKilogram, 3.57204);
+
+    add(PARSE_COMPLETE, L" 3.2 kg  lb");
+    pass(3.2, PresentationUnitKilogram, PresentationUnitPound, 7.054792);
+
+    add(PARSE_COMPLETE, L"7 lbs 14 oz kg");
+    pass(7.875, PresentationUnitPound, PresentationUnitKilogram, 3.57204);
+
+    // Compound quantities of more than two parts.
+    add(PARSE_AGAIN, L"1°");
+    add(PARSE_AGAIN, L"30arcmin");
+    add(PARSE_AGAIN, L"36arcsec");
+    add(PARSE_COMPLETE, L"°");
+    pass(1.51, PresentationUnitDegree, PresentationUnitDegree, 1.51);
+    assert(fcmp(1.51, data_.value));
+
+    add(PARSE_COMPLETE, L"1 st 2 lb 8 oz lb");
+    pass(16.5 / 14, PresentationUnitStone, PresentationUnitPound, 16.5);
+
+    add(PARSE_AGAIN, L"1°");
+    add(PARSE_INVALID_COMPOUND, L"30arcsec");
+
+    // Multiple destinations.
+    wchar_t list[] = L"Pa,hPa,psi";
+    add(PARSE_AGAIN, L"1bar");
+    add(PARSE_COMPLETE, list);
+    pass(1, PresentationUnitBar, PresentationUnitPascal, 100000);
+    assert(3 == data_.target_count);
+    assert(PresentationUnitHectoPascal == data_.targets[1]);
+    assert(PresentationUnitPoundPerSquareInch == data_.targets[2]);
+
+    wchar_t first[] = L"m,";
+    wchar_t second[] = L"in,";
+    add(PARSE_AGAIN, L"1ft");
+    add(PARSE_AGAIN, first);
+    add(PARSE_AGAIN, second);
+    add(PARSE_COMPLETE, L"*");
+    pass(1, PresentationUnitFeet, PresentationUnitMetre, 0.3048);
+    assert(12 == data_.target_count);
+    assert(PresentationUnitInch == data_.targets[1]);
+    assert(PresentationUnitMillimetre == data_.targets[2]);
+
+    wchar_t bad[] = L"m,@";
+    add(PARSE_AGAIN, L"1ft");
+    add(PARSE_UNKNOWN_UNIT, bad);
+    assert(!wcscmp(L"@", term_));
+
+    wchar_t empty[] = L",m";
+    add(PARSE_AGAIN, L"1ft");
+    add(PARSE_UNKNOWN_UNIT, empty);
+    assert(!wcscmp(L"", term_));
+
+    add(PARSE_AGAIN, L"1ft");
+    add(PARSE_COMPLETE, L"m");
+    assert(1 == data_.target_count);
+    assert(0 == data_.value_tolerance);
+
+    // Tolerance.
+    add(PARSE_AGAIN, L"12.5");
+    add(PARSE_AGAIN, L"±");
+    add(PARSE_AGAIN, L"0.1");
+    add(PARSE_AGAIN, L"mm");
+    add(PARSE_COMPLETE, L"m");
+    pass(12.5, PresentationUnitMillimetre, PresentationUnitMetre, 0.0125);
+    assert(0.1 == data_.value_tolerance);
+    assert(fcmp(0.0001, data_.tolerance));
+
+    add(PARSE_AGAIN, L"20+/-0.5°C");
+    add(PARSE_COMPLETE, L"K");
+    pass(20, PresentationUnitDegreesCelsius, PresentationUnitKelvin, 293.15);
+    assert(0.5 == data_.tolerance);
+
+    add(PARSE_AGAIN, L"5 ±0.1 ft 3 in");
+    add(PARSE_COMPLETE, L"m");
+    pass(5.25, PresentationUnitFeet, PresentationUnitMetre, 1.6002);
+    assert(fcmp(0.03048, data_.tolerance));
+
+    add(PARSE_AGAIN, L"1 ±");
+    add(PARSE_INVALID_NUMBER, L"-2");
+    assert(!wcscmp(L"-2", term_));
+
+    add(PARSE_AGAIN, L"1 +/-");
+    add(PARSE_INVALID_NUMBER, L"x");
+
+    // Only one tolerance.
+    add(PARSE_AGAIN, L"1 ± 2");
+    add(PARSE_UNKNOWN_UNIT, L"± 3 m");
+
+    parser_delete(parser_);
 }
@@ -0,0 +1,361 @@
+#include "record.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+/// Records seen by one context.
+struct seen {
+    /// Number of records.
+    size_t count;
+    /// Sum of record values.
+    size_t sum;
+    /// Length of the longest record.
+    size_t longest;
+    /// Line number at which to stop, or zero.
+    size_t stop;
+};
+
+/// Check that record @c line is its line @c number, or empty.
+static int check(void *context, char *line, size_t number)
+{
+    struct seen *seen = context;
+    size_t length = strlen(line);
+
+    if (number == seen->stop) {
+        return -ECANCELED;
+    }
+
+    assert(!*line || line[0] == 'x' || strtoul(line, NULL, 10) == number);
+    seen->count++;
+    seen->sum += number;
+    seen->longest = length > seen->longest ? length : seen->longest;
+    return 0;
+}
+
+/// Scratch file.
+static char path_[] = "/tmp/test_record.XXXXXX";
+
+/// @return Descriptor of scratch file containing @c text.
+static int file(const char *text)
+{
+    int fd = open(path_, O_RDWR | O_TRUNC);
+    assert(fd >= 0);
+    assert(write(fd, text, strlen(text)) == (ssize_t)strlen(text));
+    assert(!lseek(fd, 0, SEEK_SET));
+    return fd;
+}
+
+/// @return Descriptor of pipe containing @c text.
+static int pipe_of(const char *text)
+{
+    int fd[2];
+    assert(!pipe(fd));
+    assert(write(fd[1], text, strlen(text)) == (ssize_t)strlen(text));
+    close(fd[1]);
+    return fd[0];
+}
+
+/// @return Text of @c n numbered records.
+static char *numbered(size_t n)
+{
+    char *text = malloc(n * 8 + 1);
+    char *p = text;
+
+    assert(text);
+    for (size_t i = 1; i <= n; ++i) {
+        p += sprintf(p, "%zu\n", i);
+    }
+
+    return text;
+}
+
+static void test_read(void)
+{
+    struct seen seen = { 0 };
+    int fd;
+
+    fd = pipe_of("1\n2\n\n4");
+    assert(!record_read(fd, check, &seen));
+    assert(seen.count == 4);
+    assert(seen.sum == 10);
+    close(fd);
+
+    // Stop.
+    seen = (struct seen){ .stop = 2 };
+    fd = pipe_of("1\n2\n3\n");
+    assert(-ECANCELED == record_read(fd, check, &seen));
+    assert(seen.count == 1);
+    close(fd);
+
+    // Empty.
+    seen = (struct seen){ 0 };
+    fd = pipe_of("");
+    assert(!record_read(fd, check, &seen));
+    assert(seen.count == 0);
+    close(fd);
+
+    // Not readable.
+    fd = open("/tmp", O_RDONLY);
+    assert(-EIO == record_read(fd, check, &seen));
+    close(fd);
+}
+
+static void test_long(void)
+{
+    size_t n = 200000;
+    char *text = malloc(n + 3);
+    struct seen seen = { 0 };
+    int fd;
+
+    assert(text);
+    memset(text, 'x', n);
+    strcpy(text + n, "\n2");
+
+    fd = file(text);
+    assert(!record_read(fd, check, &seen));
+    assert(seen.count == 2);
+    assert(seen.longest == n);
+    close(fd);
+
+    seen = (struct seen){ 0 };
+    fd = file(text);
+    void *contexts[] = { &seen, &seen };
+    assert(!record_read_parallel(fd, 1, check, contexts));
+    assert(seen.count == 2);
+    close(fd);
+
+    free(text);
+}
+
+static void test_parallel(void)
+{
+    char *text = numbered(1000);
+    struct seen seen[64];
+    void *contexts[64];
+    size_t count = 0;
+    size_t sum = 0;
+    int fd;
+
+    for (size_t t = 0; t < 64; ++t) {
+        seen[t] = (struct seen){ 0 };
+        contexts[t] = &seen[t];
+    }
+
+    fd = file(text);
+    assert(!record_read_parallel(fd, 4, check, contexts));
+    close(fd);
+
+    for (size_t t = 0; t < 4; ++t) {
+        assert(seen[t].count > 0);
+        count += seen[t].count;
+        sum += seen[t].sum;
+    }
+    assert(count == 1000);
+    assert(sum == 1000 * 1001 / 2);
+
+    // More threads than records, the last without a line terminator.
+    for (size_t t = 0; t < 64; ++t) {
+        seen[t] = (struct seen){ 0 };
+    }
+    fd = file("1\n2\n3");
+    assert(!record_read_parallel(fd, 100, check, contexts));
+    close(fd);
+
+    count = 0;
+    sum = 0;
+    for (size_t t = 0; t < 64; ++t) {
+        count += seen[t].count;
+        sum += seen[t].sum;
+    }
+    assert(count == 3);
+    assert(sum == 6);
+
+    // Stop.
+    for (size_t t = 0; t < 64; ++t) {
+        seen[t] = (struct seen){ .stop = 900 };
+    }
+    fd = file(text);
+    assert(-ECANCELED == record_read_parallel(fd, 4, check, contexts));
+    close(fd);
+
+    // Not a regular file.
+    seen[0] = (struct seen){ 0 };
+    fd = pipe_of(text);
+    assert(!record_read_parallel(fd, 4, check, contexts));
+    assert(seen[0].count == 1000);
+    close(fd);
+
+    free(text);
+}
+
+static void test_async(void)
+{
+    size_t n = 200000;
+    char *text = numbered(50000);
+    char *wide = malloc(n + 3);
+    struct seen seen = { 0 };
+    int fd;
+
+    // Records span buffers.
+    fd = file(text);
+    assert(!record_read_async(fd, check, &seen));
+    assert(seen.count == 50000);
+    assert(seen.sum == (size_t)50000 * 50001 / 2);
+    assert(lseek(fd, 0, SEEK_CUR) == (off_t)strlen(text));
+    close(fd);
+
+    seen = (struct seen){ 0 };
+    fd = pipe_of("1\n2\n\n4");
+    assert(!record_read_async(fd, check, &seen));
+    assert(seen.count == 4);
+    assert(seen.sum == 10);
+    close(fd);
+
+    // A record longer than a buffer.
+    assert(wide);
+    memset(wide, 'x', n);
+    strcpy(wide + n, "\n2");
+    seen = (struct seen){ 0 };
+    fd = file(wide);
+    assert(!record_read_async(fd, check, &seen));
+    assert(seen.count == 2);
+    assert(seen.longest == n);
+    close(fd);
+
+    // Stop.
+    seen = (struct seen){ .stop = 40000 };
+    fd = file(text);
+    assert(-ECANCELED == record_read_async(fd, check, &seen));
+    assert(seen.count == 39999);
+    close(fd);
+
+    // Empty.
+    seen = (struct seen){ 0 };
+    fd = file("");
+    assert(!record_read_async(fd, check, &seen));
+    assert(seen.count == 0);
+    close(fd);
+
+    // Not readable.
+    fd = open("/tmp", O_RDONLY);
+    assert(-EIO == record_read_async(fd, check, &seen));
+    close(fd);
+
+    free(wide);
+    free(text);
+}
+
+/// Write @c text to stream @c f of record_write_async in pieces of up to @c piece bytes.
+static void put(FILE *f, const char *text, size_t piece)
+{
+    for (size_t n = strlen(text), k; n; n -= k, text += k) {
+        k = n < piece ? n : piece;
+        assert(fwrite(text, 1, k, f) == k);
+        assert(!fflush(f));
+    }
+}
+
+/// Verify that file @c fd holds @c text from offset @c at.
+static void holds(int fd, const char *text, off_t at)
+{
+    size_t n = strlen(text);
+    char *actual = malloc(n + 1);
+
+    assert(actual);
+    assert(pread(fd, actual, n + 1, at) == (ssize_t)n);
+    assert(!memcmp(actual, text, n));
+    free(actual);
+}
+
+static void test_write(void)
+{
+    char *text = numbered(100000);
+    char buffer[16];
+    FILE *f;
+    int fd;
+    int p[2];
+
+    // Several writes in flight.
+    fd = file("#");
+    assert(1 == lseek(fd, 0, SEEK_END));
+    f = record_write_async(fd);
+    assert(f);
+    put(f, text, 100000);
+    assert(!fclose(f));
+    assert(lseek(fd, 0, SEEK_CUR) == (off_t)strlen(text) + 1);
+    holds(fd, text, 1);
+    close(fd);
+
+    // Appended, in order.
+    fd = file("");
+    close(fd);
+    fd = open(path_, O_WRONLY | O_APPEND);
+    f = record_write_async(fd);
+    assert(f);
+    put(f, text, 1000);
+    assert(!fclose(f));
+    close(fd);
+    fd = open(path_, O_RDONLY);
+    holds(fd, text, 0);
+    close(fd);
+
+    // Pipe.
+    assert(!pipe(p));
+    f = record_write_async(p[1]);
+    assert(f);
+    put(f, "1\n2\n", 2);
+    assert(!fclose(f));
+    close(p[1]);
+    assert(read(p[0], buffer, sizeof(buffer)) == 4);
+    assert(!memcmp(buffer, "1\n2\n", 4));
+    close(p[0]);
+
+    // Short write, then failure, at the limit of file size.
+    struct rlimit limit;
+    assert(!getrlimit(RLIMIT_FSIZE, &limit));
+    struct rlimit small = { 100000, limit.rlim_max };
+    signal(SIGXFSZ, SIG_IGN);
+    fd = file("");
+    assert(!setrlimit(RLIMIT_FSIZE, &small));
+    f = record_write_async(fd);
+    assert(f);
+    for (size_t i = 0; i < 4; ++i) {
+        fwrite(text, 1, strlen(text), f);
+    }
+    assert(EOF == fclose(f));
+    assert(!setrlimit(RLIMIT_FSIZE, &limit));
+    close(fd);
+
+    // Not writable.
+    f = record_write_async(-1);
+    assert(f);
+    assert(fputs("x", f) >= 0);
+    assert(EOF == fclose(f));
+
+    free(text);
+}
+
+int main(void)
+{
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    int fd = mkstemp(path_);
+    assert(fd >= 0);
+    close(fd);
+
+    test_read();
+    test_long();
+    test_parallel();
+    test_async();
+    test_write();
+
+    unlink(path_);
+}
@@ -0,0 +1,174 @@
+#include "reload.h"
+#include "extension.h"
+#include "label.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <locale.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/// Number of converting threads.
+#define THREADS 8
+
+/// Number of reloads while they convert.
+#define RELOADS 20
+
+/// Scratch directory.
+static char dir_[] = "/tmp/test_reload.XXXXXX";
+/// Definitions file.
+static char path_[sizeof(dir_) + 16];
+/// Cache file.
+static char cache_[sizeof(path_) + 16];
+
+/// Write definitions of unit "fur" with @c scale.
+static void put(int scale)
+{
+    FILE *f = fopen(path_, "w");
+    assert(f);
+    fprintf(f, "unit\tfur\tm\t%d\n", scale);
+    fclose(f);
+    unlink(cache_);
+}
+
+/// @return Quantity of 1 fur in metres, or zero if unit "fur" is not defined.
+static double fur(void)
+{
+    wchar_t label[] = L"fur";
+    wchar_t *p;
+    enum base base;
+    enum unit unit = label_lookup(label, &p);
+
+    return unit == PresentationUnitUnknown ? 0 : unit_to_base(1, unit, &base);
+}
+
+static atomic_bool entered;
+static atomic_bool left;
+
+/// Convert in a section that spans a reload.
+static void *hold(void *arg)
+{
+    (void)arg;
+    assert(!extension_enter());
+    assert(201 == fur());
+    atomic_store(&entered, true);
+    usleep(20000);
+    assert(201 == fur());
+    atomic_store(&left, true);
+    extension_leave();
+    return NULL;
+}
+
+static void test_reload(void)
+{
+    struct reload_metrics m;
+    size_t line;
+
+    put(201);
+    assert(!reload(path_, &line));
+    assert(201 == fur());
+
+    reload_metrics(&m);
+    assert(1 == m.version);
+    assert(0 == m.failures);
+    assert(m.bytes > 0 && m.peak_bytes == m.bytes);
+
+    // A reader keeps the definitions current when it entered, and the reload waits for it.
+    pthread_t thread;
+    assert(!pthread_create(&thread, NULL, hold, NULL));
+    while (!atomic_load(&entered)) {
+        usleep(1000);
+    }
+    put(2010);
+    assert(!reload(path_, &line));
+    assert(atomic_load(&left));
+    assert(2010 == fur());
+    assert(!pthread_join(thread, NULL));
+
+    reload_metrics(&m);
+    assert(2 == m.version);
+    assert(m.peak_bytes > m.bytes);
+    assert(m.swap_max_ns >= m.swap_ns);
+
+    // Malformed definitions are not installed.
+    FILE *f = fopen(path_, "w");
+    assert(f);
+    fputs("unit\tfur\n", f);
+    fclose(f);
+    assert(-EINVAL == reload(path_, &line));
+    assert(1 == line);
+    assert(2010 == fur());
+
+    reload_metrics(&m);
+    assert(2 == m.version);
+    assert(1 == m.failures);
+
+    reload_release();
+    assert(0 == fur());
+    reload_metrics(&m);
+    assert(0 == m.bytes);
+}
+
+static atomic_bool done;
+
+/// Convert until done, checking that each conversion sees one version of the definitions throughout.
+static void *convert(void *arg)
+{
+    (void)arg;
+
+    while (!atomic_load(&done)) {
+        assert(!extension_enter());
+        const struct extension *ext = extension_get();
+        assert(ext && ext->scale[0] == fur());
+        extension_leave();
+    }
+
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    pthread_t threads[THREADS];
+    size_t line;
+
+    put(1);
+    assert(!reload(path_, &line));
+
+    for (size_t t = 0; t < THREADS; ++t) {
+        assert(!pthread_create(&threads[t], NULL, convert, NULL));
+    }
+
+    for (int i = 2; i <= RELOADS; ++i) {
+        put(i * 10);
+        assert(!reload(path_, &line));
+    }
+
+    atomic_store(&done, true);
+    for (size_t t = 0; t < THREADS; ++t) {
+        assert(!pthread_join(threads[t], NULL));
+    }
+
+    assert(RELOADS * 10 == fur());
+    reload_release();
+}
+
+int main(void)
+{
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    assert(mkdtemp(dir_));
+    snprintf(path_, sizeof(path_), "%s/defs", dir_);
+    snprintf(cache_, sizeof(cache_), "%s.cache", path_);
+
+    test_reload();
+    test_concurrent();
+
+    unlink(cache_);
+    unlink(path_);
+    rmdir(dir_);
+}
@@ -0,0 +1,192 @@
+#include "sketch.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// @return True if @c estimate is within relative @c accuracy of @c value.
+static int within(double estimate, double value, double accuracy)
+{
+    return fabs(estimate - value) <= accuracy * fabs(value) * (1 + 1e-9);
+}
+
+static void test_init(void)
+{
+    static struct sketch s;
+
+    assert(-EINVAL == sketch_init(&s, 0));
+    assert(-EINVAL == sketch_init(&s, 1));
+    assert(-EINVAL == sketch_init(&s, NAN));
+    assert(!sketch_init(&s, 0.01));
+
+    assert(0 == sketch_count(&s));
+    assert(isnan(sketch_quantile(&s, 0.5)));
+    assert(0 == sketch_histogram(&s, NULL, 0));
+}
+
+static void test_add(void)
+{
+    static struct sketch s;
+
+    assert(!sketch_init(&s, 0.01));
+    assert(-EINVAL == sketch_add(&s, INFINITY));
+    assert(-EINVAL == sketch_add(&s, NAN));
+
+    for (int i = 1; i <= 1000; ++i) {
+        assert(!sketch_add(&s, i));
+    }
+
+    assert(1000 == sketch_count(&s));
+    assert(isnan(sketch_quantile(&s, -0.1)));
+    assert(isnan(sketch_quantile(&s, 1.1)));
+    assert(within(sketch_quantile(&s, 0), 1, 0.01));
+    assert(within(sketch_quantile(&s, 0.5), 500, 0.01));
+    assert(within(sketch_quantile(&s, 0.99), 990, 0.01));
+    assert(within(sketch_quantile(&s, 0.999), 999, 0.01));
+    assert(within(sketch_quantile(&s, 1), 1000, 0.01));
+}
+
+static void test_sign(void)
+{
+    static struct sketch s;
+    struct sketch_bin bins[3];
+
+    assert(!sketch_init(&s, 0.02));
+    assert(!sketch_add(&s, -40));
+    assert(!sketch_add(&s, -2));
+    assert(!sketch_add(&s, -2));
+    assert(!sketch_add(&s, 0));
+    assert(!sketch_add(&s, 3));
+
+    assert(within(sketch_quantile(&s, 0), -40, 0.02));
+    assert(within(sketch_quantile(&s, 0.25), -2, 0.02));
+    assert(within(sketch_quantile(&s, 0.5), -2, 0.02));
+    assert(0 == sketch_quantile(&s, 0.75));
+    assert(within(sketch_quantile(&s, 1), 3, 0.02));
+
+    // In ascending order; the last bin does not fit.
+    assert(4 == sketch_histogram(&s, bins, 3));
+    assert(bins[0].lower <= -40 && -40 <= bins[0].upper && 1 == bins[0].count);
+    assert(bins[1].lower <= -2 && -2 <= bins[1].upper && 2 == bins[1].count);
+    assert(0 == bins[2].lower && 0 == bins[2].upper && 1 == bins[2].count);
+}
+
+static void test_collapse(void)
+{
+    static struct sketch s;
+
+    // Values span far more bins than the store holds; the least are collapsed.
+    assert(!sketch_init(&s, 0.01));
+    assert(!sketch_add(&s, 1e-300));
+    assert(!sketch_add(&s, 1));
+    assert(!sketch_add(&s, 1e10));
+    assert(!sketch_add(&s, 1e300));
+
+    assert(4 == sketch_count(&s));
+    assert(sketch_quantile(&s, 0) == sketch_quantile(&s, 0.5));
+    assert(within(sketch_quantile(&s, 1), 1e300, 0.01));
+
+    // Greater than the store holds at once, collapsing everything.
+    assert(!sketch_init(&s, 0.01));
+    assert(!sketch_add(&s, -1e-300));
+    assert(!sketch_add(&s, -1e-300));
+    assert(!sketch_add(&s, -1e300));
+    assert(within(sketch_quantile(&s, 0), -1e300, 0.01));
+    assert(sketch_quantile(&s, 0.5) == sketch_quantile(&s, 1));
+}
+
+static void test_merge(void)
+{
+    static struct sketch a;
+    static struct sketch b;
+    static struct sketch c;
+
+    assert(!sketch_init(&a, 0.01));
+    assert(!sketch_init(&b, 0.01));
+    assert(!sketch_init(&c, 0.05));
+
+    for (int i = 1; i <= 100; ++i) {
+        assert(!sketch_add(i % 2 ? &a : &b, i));
+    }
+    assert(!sketch_add(&b, 0));
+    assert(!sketch_add(&b, -1));
+
+    assert(-EINVAL == sketch_merge(&a, &c));
+    assert(!sketch_merge(&a, &b));
+    assert(102 == sketch_count(&a));
+    assert(within(sketch_quantile(&a, 0), -1, 0.01));
+    assert(within(sketch_quantile(&a, 0.5), 49, 0.01));
+    assert(within(sketch_quantile(&a, 1), 100, 0.01));
+}
+
+static void test_serialize(void)
+{
+    static struct sketch s;
+    static struct sketch t;
+    struct sketch_bin a[101];
+    struct sketch_bin b[101];
+    uint8_t buffer[256];
+    size_t n;
+
+    assert(!sketch_init(&s, 0.01));
+    for (int i = -50; i <= 50; ++i) {
+        assert(!sketch_add(&s, i * 1.5));
+    }
+    for (int i = 0; i < 200; ++i) {
+        assert(!sketch_add(&s, 0));
+    }
+
+    n = sketch_serialize(&s, NULL, 0);
+    assert(n <= sizeof(buffer));
+    assert(n == sketch_serialize(&s, buffer, sizeof(buffer)));
+
+    assert(!sketch_deserialize(&t, buffer, n));
+    assert(sketch_count(&s) == sketch_count(&t));
+    assert(0 == sketch_quantile(&s, 0.5));
+    n = sketch_histogram(&s, a, 101);
+    assert(n == sketch_histogram(&t, b, 101));
+    assert(!memcmp(a, b, n * sizeof(*a)));
+    n = sketch_serialize(&s, buffer, sizeof(buffer));
+
+    // Truncated, extended or corrupt.
+    assert(-EINVAL == sketch_deserialize(&t, buffer, 4));
+    assert(-EINVAL == sketch_deserialize(&t, buffer, n - 1));
+    assert(-EINVAL == sketch_deserialize(&t, buffer, n + 1));
+    buffer[0] = 'X';
+    assert(-EINVAL == sketch_deserialize(&t, buffer, n));
+
+    // Bad accuracy.
+    static const uint8_t accuracy[] = { 'U', 'S', 'K', 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    assert(-EINVAL == sketch_deserialize(&t, accuracy, sizeof(accuracy)));
+
+    // Varint too long.
+    uint8_t varint[32] = { 'U', 'S', 'K', 1 };
+    memcpy(varint + 4, buffer + 4, 8);
+    memset(varint + 12, 0xff, sizeof(varint) - 12);
+    assert(-EINVAL == sketch_deserialize(&t, varint, sizeof(varint)));
+
+    // Bin of no values.
+    uint8_t empty[] = { 'U', 'S', 'K', 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 0, 0 };
+    memcpy(empty + 4, buffer + 4, 8);
+    assert(-EINVAL == sketch_deserialize(&t, empty, sizeof(empty)));
+
+    // Key beyond the range of any double.
+    uint8_t key[] = { 'U', 'S', 'K', 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0x80, 0x80, 0x80, 0x80, 0x01, 1, 0 };
+    memcpy(key + 4, buffer + 4, 8);
+    assert(-EINVAL == sketch_deserialize(&t, key, sizeof(key)));
+}
+
+int main(void)
+{
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    test_init();
+    test_add();
+    test_sign();
+    test_collapse();
+    test_merge();
+    test_serialize();
+}
@@ -0,0 +1,77 @@
+#include "unico.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cwchar>
+
+using namespace unico;
+
+/// Fuzzy compare.
+static constexpr bool fcmp(double x, double y)
+{
+    return (x - y) < 0.00001 && (y - x) < 0.00001;
+}
+
+// Compile-time label resolution.
+static_assert(unit_of("m") == PresentationUnitMetre);
+static_assert(unit_of("psi") == PresentationUnitPoundPerSquareInch);
+static_assert(unit_of("°F") == PresentationUnitDegreesFahrenheit);
+static_assert(unit_of(L"°C") == PresentationUnitDegreesCelsius);
+static_assert(unit_of("long tons") == PresentationUnitLongTon);
+static_assert(unit_of("'\"") == PresentationUnitFeetAndInches);
+static_assert("kg"_unit == PresentationUnitKilogram);
+
+// A truncated UTF-8 sequence is not read past its end.
+constexpr char truncated[] = { 'm', '\xc2' };
+static_assert([] { std::size_t i = 1; return detail::decode(truncated, 2, i) == detail::invalid && i == 2; }());
+static_assert([] { std::size_t i = 0; return detail::decode("\xc2m", 2, i) == detail::invalid && i == 1; }());
+static_assert(!detail::equal(L"°", "°", 1));
+
+// Compile-time conversion.
+static_assert(compatible(PresentationUnitFeet, PresentationUnitMetre));
+static_assert(!compatible(PresentationUnitFeet, PresentationUnitKilogram));
+static_assert(!compatible(PresentationUnitNone, PresentationUnitNone));
+static_assert(fcmp(convert<PresentationUnitInch, PresentationUnitMillimetre>(1), 25.4));
+static_assert(fcmp(convert<"°F", "K">(80.33), 300));
+static_assert(fcmp(convert<"K", "°C">(300), 26.85));
+static_assert(fcmp(convert<"°C", "°F">(100), 212));
+static_assert(fcmp(quantity_cast<"bar"_unit>(quantity<"psi"_unit>(14.5037738)).value, 1));
+static_assert(quantity<"psi"_unit>::unit == PresentationUnitPoundPerSquareInch);
+
+/// Test that the C++ conversion agrees with the C conversion.
+static void agree(enum unit unit)
+{
+    enum base base;
+    double q = unit_to_base(2, unit, &base);
+    double expected;
+
+    assert(base == base_of(unit));
+    assert(!wcscmp(symbol_of_unit(unit), symbol_of(unit)));
+
+    for (int to = PresentationUnitUnknown + 1; symbol_of(static_cast<enum unit>(to)); ++to) {
+        double actual = convert(2, unit, static_cast<enum unit>(to));
+
+        if (base_to_unit(q, base, static_cast<enum unit>(to), &expected)) {
+            assert(std::isnan(actual));
+        } else {
+            assert(fcmp(expected, actual));
+        }
+    }
+}
+
+int main()
+{
+    assert(std::isnan(convert(1, PresentationUnitUnknown, PresentationUnitMetre)));
+
+    bool unknown = false;
+    try {
+        unit_of(truncated, sizeof(truncated));
+    } catch (const std::invalid_argument &) {
+        unknown = true;
+    }
+    assert(unknown);
+
+#define u(symbol, name, base, scale) \
+    agree(name);
+#include "unit.hi"
+}
@@ -1,11 +1,15 @@
 #include "unit.h"
+#include "extension.h"
+#include "label.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <locale.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <wchar.h>
 
 /// Fuzzy compare.
 static bool fcmp(double x, double y)
@@ -42,8 +46,8 @@ static void test_unit_to_base(void)
 #define u(symbol, name, base, scale) \
     wrap_unit_to_base(1, name, scale, base);
 
-#define c(symbol, name, base, tobase, frombase) \
-    { float  X=1; wrap_unit_to_base(1, name, tobase, base); }
+#define c(symbol, name, base, scale, offset) \
+    wrap_unit_to_base(1, name, (1 + offset) * scale, base);
 
 #include "unit.hi"
 }
@@ -65,8 +69,8 @@ static void test_base_unit_to_unit(void)
 #define u(symbol, name, base, scale) \
     wrap_base_to_unit(scale, base, name, 1);
 
-#define c(symbol, name, base, tobase, frombase) \
-    { float  X=1; wrap_base_to_unit(tobase, base, name, 1); }
+#define c(symbol, name, base, scale, offset) \
+    wrap_base_to_unit((1 + offset) * scale, base, name, 1);
 
 #include "unit.hi"
 }
@@ -96,6 +100,7 @@ static void test_base_render(void)
     expect(base_render(1000, BaseUnitMetre, PresentationUnitMile),          "0.621371 mi");
     expect(base_render(1, BaseUnitMetre, PresentationUnitYard),             "1.09361 yd");
     expect(base_render(1, BaseUnitMetre, PresentationUnitFeetAndInches),    "3 ' 3.37008 \"");
+    expect(base_render(1, BaseUnitMetre, PresentationUnitFeetAndSixteenths), "3 ' 3 3/8 \"");
     expect(base_render(1, BaseUnitMetre, PresentationUnitFeet),             "3.28084 ft");
     expect(base_render(1, BaseUnitMetre, PresentationUnitInch),            "39.3701 in");
 
@@ -126,7 +131,10 @@ static void test_base_render(void)
     expect(base_render(2, BaseUnitKilogram, PresentationUnitTonne),         "0.002 t");
     expect(base_render(2000, BaseUnitKilogram, PresentationUnitShortTon),   "2.20462 tn");
     expect(base_render(2000, BaseUnitKilogram, PresentationUnitLongTon),    "1.96841 long ton");
+    expect(base_render(70, BaseUnitKilogram, PresentationUnitStone),        "11.0231 st");
+    expect(base_render(70, BaseUnitKilogram, PresentationUnitStoneAndPound), "11 st 0.323584 lb");
     expect(base_render(2, BaseUnitKilogram, PresentationUnitPound),         "4.40925 lb");
+    expect(base_render(2, BaseUnitKilogram, PresentationUnitPoundAndOunce), "4 lb 6.54792 oz");
     expect(base_render(2, BaseUnitKilogram, PresentationUnitOunce),        "70.5479 oz");
 
     expect(base_render(300, BaseUnitKelvin, PresentationUnitKelvin),            "300 K");
@@ -144,6 +152,326 @@ static void test_base_render(void)
 
     expect(base_render(3.1415926536, DerivedUnitAngleRadian, PresentationUnitRadian), "3.14159 rad");
     expect(base_render(3.1415926536, DerivedUnitAngleRadian, PresentationUnitDegree), "180 °");
+    expect(base_render(1, DerivedUnitAngleRadian, PresentationUnitDegreeMinuteSecond), "57 ° 17 ′ 44.8062 ″");
+    expect(base_render(1, DerivedUnitAngleRadian, PresentationUnitArcminute), "3437.75 arcmin");
+    expect(base_render(1, DerivedUnitAngleRadian, PresentationUnitArcsecond), "206265 arcsec");
+}
+
+static void test_unit_render(void)
+{
+    expect(unit_render(1, PresentationUnitNone),          NULL);
+    expect(unit_render(1, PresentationUnitUnknown),       NULL);
+    expect(unit_render(0.1, PresentationUnitFeet),        "0.1 ft");
+    expect(unit_render(6.25, PresentationUnitFeetAndInches), "6 ' 3 \"");
+    expect(unit_render(98.6, PresentationUnitDegreesFahrenheit), "98.6 °F");
+}
+
+static void test_mixed(void)
+{
+    char buffer[4];
+
+    assert(unit_compound(PresentationUnitFeet, PresentationUnitInch));
+    assert(unit_compound(PresentationUnitFeet, PresentationUnitNone));
+    assert(unit_compound(PresentationUnitDegree, PresentationUnitArcminute));
+    assert(unit_compound(PresentationUnitArcminute, PresentationUnitArcsecond));
+    assert(!unit_compound(PresentationUnitDegree, PresentationUnitArcsecond));
+    assert(!unit_compound(PresentationUnitInch, PresentationUnitNone));
+    assert(!unit_compound(PresentationUnitOunce, PresentationUnitPound));
+
+    // Sign applies to the whole quantity.
+    expect(unit_render(-6.25, PresentationUnitFeetAndInches), "-6 ' 3 \"");
+    expect(unit_render(10.5, PresentationUnitStoneAndPound), "10 st 7 lb");
+
+    // Rounding carries into greater parts.
+    expect(unit_render(5.9999999, PresentationUnitFeetAndInches), "6 ' 0 \"");
+    expect(unit_render(5 + 11.99 / 12, PresentationUnitFeetAndSixteenths), "6 ' 0 \"");
+    expect(unit_render(1.99999999 / 60, PresentationUnitDegreeMinuteSecond), "0 ° 2 ′ 0 ″");
+    expect(unit_render(59.9999999999, PresentationUnitDegreeMinuteSecond), "60 ° 0 ′ 0 ″");
+    expect(unit_render(59.9999, PresentationUnitDegreeMinuteSecond), "59 ° 59 ′ 59.64 ″");
+    expect(unit_render(1 + 9.999996 / 3600, PresentationUnitDegreeMinuteSecond), "1 ° 0 ′ 10 ″");
+    expect(unit_render(1 + 9.999994 / 3600, PresentationUnitDegreeMinuteSecond), "1 ° 0 ′ 9.99999 ″");
+
+    // Fractions are reduced.
+    expect(unit_render(6 + 3.5 / 12, PresentationUnitFeetAndSixteenths), "6 ' 3 1/2 \"");
+    expect(unit_render(5.0 / 16 / 12, PresentationUnitFeetAndSixteenths), "0 ' 5/16 \"");
+
+    // Too great to count in parts.
+    expect(unit_render(1e300, PresentationUnitFeetAndInches), "1e+300 ' 0 \"");
+    expect(unit_render(-1e20, PresentationUnitDegreeMinuteSecond), "-1e+20 ° 0 ′ 0 ″");
+    expect(unit_render(NAN, PresentationUnitFeetAndInches), "nan '");
+
+    // Truncated.
+    assert(7 == unit_format(6.25, PresentationUnitFeetAndInches, buffer, sizeof(buffer)));
+    assert(!strcmp(buffer, "6 '"));
+    assert(7 == unit_format(6.25, PresentationUnitFeetAndInches, NULL, 0));
+    assert(3 == unit_format(1, PresentationUnitMetre, buffer, sizeof(buffer)));
+    assert(!strcmp(buffer, "1 m"));
+    assert(-EINVAL == unit_format(1, PresentationUnitNone, buffer, sizeof(buffer)));
+    assert(-EPERM == base_format(1, BaseUnitKelvin, PresentationUnitFeet, buffer, sizeof(buffer)));
+    assert(7 == base_format(0.3048, BaseUnitMetre, PresentationUnitFeetAndInches, NULL, 0));
+
+    // Symbol not represented in the locale.
+    setlocale(LC_ALL, "C");
+    assert(0 > unit_format(1, PresentationUnitDegreeMinuteSecond, buffer, sizeof(buffer)));
+    expect(unit_render(1, PresentationUnitDegreeMinuteSecond), NULL);
+    setlocale(LC_ALL, "en_US.UTF-8");
+}
+
+/// Parse the parts of @c degrees rendered in degrees, minutes and seconds by their labels.
+static void round_trip(double degrees)
+{
+    char *rendered = unit_render(degrees, PresentationUnitDegreeMinuteSecond);
+    wchar_t text[64];
+    wchar_t *p = text;
+    enum base base;
+    double total = 0;
+    double sign = 1;
+
+    assert(rendered && mbstowcs(text, rendered, 64) < 64);
+    free(rendered);
+
+    while (*p) {
+        double quantity = wcstod(p, &p);
+        enum unit unit = label_lookup(p + 1, &p);
+
+        assert(unit == PresentationUnitDegree || unit == PresentationUnitArcminute
+            || unit == PresentationUnitArcsecond);
+        // The sign of the degrees applies to the whole quantity.
+        sign = unit == PresentationUnitDegree && signbit(quantity) ? -1 : sign;
+        total += sign * fabs(unit_to_base(quantity, unit, &base));
+        p += *p == L' ';
+    }
+
+    assert(fcmp(total * 180 / M_PI, degrees));
+}
+
+static void test_round_trip(void)
+{
+    round_trip(0);
+    round_trip(57.2958);
+    round_trip(-12.3456);
+    round_trip(-0.5);
+    round_trip(359.999999);
+}
+
+static void test_conversion(void)
+{
+    struct unit_conversion c;
+    struct unit_conversion inexact;
+    double a[] = { -40, 0, 100 };
+
+    assert(-1 == unit_conversion(PresentationUnitMetre, PresentationUnitKilogram, &c));
+    assert(-1 == unit_conversion(PresentationUnitNone, PresentationUnitMetre, &c));
+    assert(-1 == unit_conversion(PresentationUnitMetre, PresentationUnitUnknown, &c));
+
+    // Exact factors are fused without re-rounding through the base unit.
+    assert(!unit_conversion(PresentationUnitInch, PresentationUnitFeet, &c));
+    assert(c.exact);
+    assert(1 == unit_convert(&c, 12));
+    for (int i = 1; i < 10000; ++i) {
+        double x = i * 0.37;
+        assert(unit_convert(&c, x) == (double)((long double)x / 12));
+    }
+
+    assert(!unit_conversion(PresentationUnitPound, PresentationUnitKilogram, &c));
+    assert(c.exact);
+    assert(0.45359237 == unit_convert(&c, 1));
+
+    assert(!unit_conversion(PresentationUnitMile, PresentationUnitKilometre, &c));
+    assert(1.609344 == unit_convert(&c, 1));
+
+    assert(!unit_conversion(PresentationUnitDegreesFahrenheit, PresentationUnitKelvin, &c));
+    assert(c.exact);
+    assert(273.15 == unit_convert(&c, 32));
+
+    assert(!unit_conversion(PresentationUnitDegreesCelsius, PresentationUnitDegreesFahrenheit, &c));
+    assert(c.exact);
+    assert(212 == unit_convert(&c, 100));
+    assert(98.6 == unit_convert(&c, 37));
+
+    unit_convert_array(&c, a, a, sizeof(a) / sizeof(*a));
+    assert(a[0] == -40 && a[1] == 32 && a[2] == 212);
+
+    // Scale is not an exact decimal.
+    assert(!unit_conversion(PresentationUnitDegree, PresentationUnitRadian, &inexact));
+    assert(!inexact.exact);
+    assert(fcmp(M_PI, unit_convert(&inexact, 180)));
+
+    unit_convert_array(&inexact, a, a, sizeof(a) / sizeof(*a));
+    assert(fcmp(a[2], 212 * M_PI / 180));
+
+    // Fused denominator exceeds 2^53.
+    assert(!unit_conversion(PresentationUnitCubicInch, PresentationUnitCubicMetre, &inexact));
+    assert(!inexact.exact);
+    assert(fcmp(1.6387064069264E-5, unit_convert(&inexact, 1)));
+}
+
+static void test_fixed(void)
+{
+    struct unit_conversion_fixed c;
+    int64_t out;
+    int64_t a[] = { -40000, 0, 37000, 100000 };
+    int32_t b[] = { -40000, 0, INT32_MAX / 10, INT32_MIN / 10 };
+
+    assert(-EPERM == unit_conversion_fixed(PresentationUnitMetre, 0, PresentationUnitKilogram, 0, &c));
+    assert(-ERANGE == unit_conversion_fixed(PresentationUnitMetre, -19, PresentationUnitMetre, 0, &c));
+    assert(-ERANGE == unit_conversion_fixed(PresentationUnitMetre, 0, PresentationUnitMetre, 19, &c));
+    // Denominator exceeds 2^62.
+    assert(-ERANGE == unit_conversion_fixed(PresentationUnitArcsecond, 0, PresentationUnitRadian, 0, &c));
+
+    // Milli-units, with offset.
+    assert(!unit_conversion_fixed(PresentationUnitDegreesCelsius, -3, PresentationUnitKelvin, -3, &c));
+    assert(!unit_convert_fixed(&c, 20000, &out) && out == 293150);
+    assert(!unit_convert_fixed(&c, -273150, &out) && out == 0);
+
+    assert(!unit_conversion_fixed(PresentationUnitDegreesFahrenheit, -3, PresentationUnitDegreesCelsius, -3, &c));
+    assert(!unit_convert_fixed_array(&c, a, a, sizeof(a) / sizeof(*a)));
+    assert(a[0] == -40000 && a[1] == -17778 && a[2] == 2778 && a[3] == 37778);
+
+    assert(!unit_conversion_fixed(PresentationUnitKiloPascal, 0, PresentationUnitPascal, -3, &c));
+    assert(!unit_convert_fixed(&c, -101, &out) && out == -101000000);
+
+    // Rounded to nearest, with ties away from zero, exactly.
+    assert(!unit_conversion_fixed(PresentationUnitInch, -3, PresentationUnitFeet, -3, &c));
+    for (int64_t x = -100000; x <= 100000; ++x) {
+        int64_t expected = x < 0 ? -((-2 * x + 12) / 24) : (2 * x + 12) / 24;
+        assert(!unit_convert_fixed(&c, x, &out) && out == expected);
+    }
+    for (int64_t x = INT64_MAX; x > INT64_MAX - 1000; --x) {
+        __int128 expected = ((__int128)2 * x + 12) / 24;
+        assert(!unit_convert_fixed(&c, x, &out) && out == expected);
+        assert(!unit_convert_fixed(&c, -x, &out) && out == -expected);
+    }
+
+    assert(!unit_conversion_fixed(PresentationUnitPound, 0, PresentationUnitGram, -3, &c));
+    assert(!unit_convert_fixed(&c, 1, &out) && out == 453592);
+    assert(!unit_convert_fixed(&c, 3, &out) && out == 1360777);
+
+    // Saturated.
+    assert(!unit_conversion_fixed(PresentationUnitKilometre, 0, PresentationUnitMillimetre, 0, &c));
+    assert(-ERANGE == unit_convert_fixed(&c, INT64_MAX / 100000, &out) && out == INT64_MAX);
+    assert(-ERANGE == unit_convert_fixed(&c, INT64_MIN / 100000, &out) && out == INT64_MIN);
+    assert(!unit_conversion_fixed(PresentationUnitMillimetre, 0, PresentationUnitKilometre, 0, &c));
+    assert(!unit_convert_fixed(&c, INT64_MAX, &out) && out == 9223372036855);
+    assert(!unit_convert_fixed(&c, INT64_MIN, &out) && out == -9223372036855);
+
+    assert(!unit_conversion_fixed(PresentationUnitMetre, 0, PresentationUnitCentimetre, 0, &c));
+    assert(-ERANGE == unit_convert_fixed_array32(&c, b, b, sizeof(b) / sizeof(*b)));
+    assert(b[0] == -4000000 && b[1] == 0 && b[2] == INT32_MAX && b[3] == INT32_MIN);
+    b[2] = 21474836;
+    assert(!unit_convert_fixed_array32(&c, b + 2, b + 2, 1) && b[2] == 2147483600);
+
+    // Scale is not an exact decimal.
+    assert(!unit_conversion_fixed(PresentationUnitDegree, -3, PresentationUnitRadian, -3, &c));
+    assert(!unit_convert_fixed(&c, 180000, &out) && out == 3142);
+    assert(!unit_convert_fixed(&c, -90000, &out) && out == -1571);
+}
+
+static void test_tolerance(void)
+{
+    struct unit_conversion c;
+    enum base base;
+    double actual;
+    double a[] = { 0, 100 };
+    double t[] = { 0.5, -1 };
+
+    // Offset does not apply.
+    assert(0.5 == unit_to_base_tolerance(0.5, PresentationUnitDegreesCelsius, &base));
+    assert(BaseUnitKelvin == base);
+    assert(fcmp(5.0 / 18, unit_to_base_tolerance(-0.5, PresentationUnitDegreesFahrenheit, &base)));
+
+    assert(!base_to_unit_tolerance(0.5, BaseUnitKelvin, PresentationUnitDegreesFahrenheit, &actual));
+    assert(fcmp(0.9, actual));
+    assert(!base_to_unit_tolerance(0.5, BaseUnitKelvin, PresentationUnitDegreesFahrenheit, NULL));
+    assert(-EPERM == base_to_unit_tolerance(0.5, BaseUnitMetre, PresentationUnitKelvin, &actual));
+
+    assert(!unit_conversion(PresentationUnitDegreesCelsius, PresentationUnitDegreesFahrenheit, &c));
+    assert(c.exact);
+    assert(0.9 == unit_convert_tolerance(&c, 0.5));
+    assert(0.9 == unit_convert_tolerance(&c, -0.5));
+
+    unit_convert_tolerance_array(&c, a, t, a, t, sizeof(a) / sizeof(*a));
+    assert(a[0] == 32 && a[1] == 212);
+    assert(t[0] == 0.9 && t[1] == 1.8);
+
+    assert(!unit_conversion(PresentationUnitDegree, PresentationUnitRadian, &c));
+    assert(!c.exact);
+    unit_convert_tolerance_array(&c, a, t, a, t, sizeof(a) / sizeof(*a));
+    assert(fcmp(a[1], 212 * M_PI / 180));
+    assert(fcmp(t[1], 1.8 * M_PI / 180));
+
+    expect(unit_render_tolerance(1, 0.5, PresentationUnitNone), NULL);
+    expect(unit_render_tolerance(12.5, 0.1, PresentationUnitMillimetre), "12.5 ± 0.1 mm");
+    expect(unit_render_tolerance(6.25, 0.01, PresentationUnitFeetAndInches), "6 ' 3 \" ± 0.12 \"");
+}
+
+static void test_base_units(void)
+{
+    enum unit units[16];
+    double out[3];
+
+    assert(0 == base_units(BaseUnitNone, units, 16));
+    assert(3 == base_units(BaseUnitKelvin, NULL, 0));
+    assert(10 == base_units(BaseUnitMetre, units, 2));
+    assert(units[0] == PresentationUnitMillimetre);
+    assert(units[1] == PresentationUnitCentimetre);
+    assert(10 == base_units(BaseUnitMetre, units, 16));
+    assert(units[9] == PresentationUnitInch);
+
+    const enum unit targets[] = { PresentationUnitFeet, PresentationUnitKilogram, PresentationUnitInch };
+    assert(!base_to_units(0.3048, BaseUnitMetre, targets, 1, out));
+    assert(fcmp(1, out[0]));
+    assert(-EPERM == base_to_units(0.3048, BaseUnitMetre, targets, 3, out));
+    assert(fcmp(1, out[0]));
+    assert(isnan(out[1]));
+    assert(fcmp(12, out[2]));
+}
+
+static void test_extension(void)
+{
+    static const uint32_t symbol[] = { 0 };
+    static const int32_t base[] = { BaseUnitMetre };
+    static const double scale[] = { 201.168 };
+    static const double offset[] = { 0 };
+    static const struct extension ext = {
+        .units = 1, .symbol = symbol, .base = base, .scale = scale, .offset = offset, .strings = L"fur"
+    };
+    enum base b;
+    double actual;
+
+    assert(NULL == symbol_of_unit(PresentationUnitCount));
+
+    extension_set(&ext);
+    assert(!wcscmp(symbol_of_unit(PresentationUnitCount), L"fur"));
+    assert(NULL == symbol_of_unit(PresentationUnitCount + 1));
+    assert(!wcscmp(symbol_of_unit(PresentationUnitMetre), L"m"));
+
+    wrap_unit_to_base(1, PresentationUnitCount, 201.168, BaseUnitMetre);
+    wrap_base_to_unit(201.168, BaseUnitMetre, PresentationUnitCount, 1);
+    assert(201.168 == unit_to_base_tolerance(1, PresentationUnitCount, &b));
+    assert(-1 == base_to_unit(42, BaseUnitKilogram, PresentationUnitCount, &actual));
+    unit_to_base(1, PresentationUnitCount + 1, &b);
+    assert(b == BaseUnitNone);
+
+    expect(base_render(402.336, BaseUnitMetre, PresentationUnitCount), "2 fur");
+
+    enum unit units[16];
+    assert(11 == base_units(BaseUnitMetre, units, 16));
+    assert(units[10] == PresentationUnitCount);
+    assert(11 == base_units(BaseUnitMetre, units, 10));
+
+    struct unit_conversion c;
+    assert(!unit_conversion(PresentationUnitCount, PresentationUnitMetre, &c));
+    assert(!c.exact);
+    assert(fcmp(201.168, unit_convert(&c, 1)));
+    assert(!unit_conversion(PresentationUnitKilometre, PresentationUnitCount, &c));
+    assert(fcmp(4.97096954, unit_convert(&c, 1)));
+
+    struct unit_conversion_fixed f;
+    int64_t out;
+    assert(!unit_conversion_fixed(PresentationUnitCount, 0, PresentationUnitMetre, -3, &f));
+    assert(!unit_convert_fixed(&f, 2, &out) && out == 402336);
+    extension_set(NULL);
 }
 
 int main(void)
@@ -155,4 +483,12 @@ int main(void)
     test_unit_to_base();
     test_base_unit_to_unit();
     test_base_render();
+    test_unit_render();
+    test_mixed();
+    test_round_trip();
+    test_conversion();
+    test_fixed();
+    test_tolerance();
+    test_base_units();
+    test_extension();
 }
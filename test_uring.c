@@ -0,0 +1,113 @@
+#include "uring.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/// Scratch file.
+static char path_[] = "/tmp/test_uring.XXXXXX";
+
+static void test_new(void)
+{
+    struct uring *u = (struct uring *)&u;
+
+    // No entries.
+    assert(-ENOSYS == uring_new(0, 16, &u));
+    assert(!u);
+
+    uring_delete(NULL);
+}
+
+static void test_file(void)
+{
+    struct uring *u;
+    unsigned i = 9;
+    int result = 0;
+    int fd = open(path_, O_RDWR | O_TRUNC);
+
+    assert(fd >= 0);
+    assert(!uring_new(2, 16, &u));
+
+    // Nothing in flight.
+    assert(0 == uring_complete(u, false, &i, &result));
+    assert(i == 9);
+
+    memcpy(uring_buffer(u, 0), "0123456789", 10);
+    memcpy(uring_buffer(u, 1), "abcdef", 6);
+    uring_write(u, fd, 0, 0, 10, 0);
+    uring_write(u, fd, 1, 2, 4, 10);
+
+    for (int n = 0; n < 2; ++n) {
+        assert(1 == uring_complete(u, true, &i, &result));
+        assert(result == (i ? 4 : 10));
+    }
+
+    // Read, without waiting until the read completes.
+    memset(uring_buffer(u, 1), 0, 16);
+    uring_read(u, fd, 1, 1, 15, 8);
+    while (!uring_complete(u, false, &i, &result)) {
+    }
+    assert(i == 1 && result == 6);
+    assert(!memcmp(uring_buffer(u, 1), "\0" "89cdef", 7));
+
+    // At the file position.
+    assert(0 == lseek(fd, 0, SEEK_SET));
+    uring_read(u, fd, 0, 0, 4, -1);
+    assert(1 == uring_complete(u, true, &i, &result));
+    assert(i == 0 && result == 4);
+    assert(4 == lseek(fd, 0, SEEK_CUR));
+
+    // Failure.
+    uring_read(u, -1, 0, 0, 4, -1);
+    assert(1 == uring_complete(u, true, &i, &result));
+    assert(result == -EBADF);
+
+    uring_delete(u);
+    close(fd);
+}
+
+static void test_pipe(void)
+{
+    struct uring *u;
+    unsigned i;
+    int result;
+    int fd[2];
+
+    assert(!pipe(fd));
+    assert(!uring_new(1, 8, &u));
+
+    // Read waits for a write.
+    uring_read(u, fd[0], 0, 0, 8, -1);
+    assert(0 == uring_complete(u, false, &i, &result));
+    assert(3 == write(fd[1], "abc", 3));
+    assert(1 == uring_complete(u, true, &i, &result));
+    assert(i == 0 && result == 3);
+    assert(!memcmp(uring_buffer(u, 0), "abc", 3));
+
+    close(fd[1]);
+    uring_read(u, fd[0], 0, 0, 8, -1);
+    assert(1 == uring_complete(u, true, &i, &result));
+    assert(result == 0);
+
+    uring_delete(u);
+    close(fd[0]);
+}
+
+int main(void)
+{
+    setlocale(LC_ALL, "en_US.UTF-8");
+
+    int fd = mkstemp(path_);
+    assert(fd >= 0);
+    close(fd);
+
+    test_new();
+    test_file();
+    test_pipe();
+
+    unlink(path_);
+}
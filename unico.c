@@ -1,14 +1,63 @@
+#include "aggregate.h"
+#include "cache.h"
+#include "definition.h"
+#include "extract.h"
 #include "label.h"
 #include "parser.h"
+#include "record.h"
+#include "reload.h"
 #include "unit.h"
 
 #include <errno.h>
 #include <getopt.h>
 #include <locale.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wctype.h>
+
+/// Initialize locale from the environment, once.
+/// The locale is loaded only when it is needed, since loading it dominates the time to convert a quantity.
+static void locale(void)
+{
+    static bool initialized;
+
+    if (!initialized) {
+        setlocale(LC_ALL, "");
+        initialized = true;
+    }
+}
+
+/// @return True if locale category @c name is selected by the environment as the C locale, or as C with a character
+/// set such as C.UTF-8, so that the locale is needed only for multibyte text.
+static bool plain(const char *name)
+{
+    const char *value = getenv("LC_ALL");
+
+    value = value && *value ? value : getenv(name);
+    value = value && *value ? value : getenv("LANG");
+
+    return !value || !*value || !strcmp(value, "C") || !strcmp(value, "POSIX") || !strncmp(value, "C.", 2);
+}
+
+/// @return @c s, having initialized the locale if @c s contains characters outside ASCII.
+static const wchar_t *text(const wchar_t *s)
+{
+    for (const wchar_t *p = s; p && *p; ++p) {
+        if ((unsigned long)*p > 0x7f) {
+            locale();
+            break;
+        }
+    }
+
+    return s;
+}
 
 /// @return wide string of @c arg.
 static wchar_t *str_to_wcs(const char *arg)
@@ -18,11 +67,19 @@ static wchar_t *str_to_wcs(const char *arg)
     if (arg) {
         size_t len = strlen(arg) + 1 /*NUL*/;
 
+        for (size_t i = 0; i < len; ++i) {
+            if ((unsigned char)arg[i] > 0x7f) {
+                locale();
+                break;
+            }
+        }
+
         wcs = (wchar_t *)malloc(sizeof(wchar_t) * len);
         if (wcs) {
             size_t ret = mbstowcs(wcs, arg, len);
             if (ret == (size_t)-1) {
                 free(wcs);
+                wcs = NULL;
             }
         }
     } else {
@@ -35,7 +92,11 @@ static wchar_t *str_to_wcs(const char *arg)
 __attribute__((noreturn))
 static void synopsis(void)
 {
-    fprintf(stderr, "usage: unico [-hl] [QUANTITY FROM TO]...\n");
+    fprintf(stderr,
+        "usage: unico [-hltx] [-d FILE] [QUANTITY [+/- TOLERANCE] FROM TO]...\n"
+        "       unico [-t] [-d FILE] [-j JOBS] -a TO\n"
+        "       unico [-tux] [-c ENTRIES] [-d FILE] -b\n"
+        "       unico [-t] [-d FILE] -e TO | -E TO\n");
     exit(EXIT_SUCCESS);
 }
 
@@ -43,13 +104,38 @@ __attribute__((noreturn))
 static void help(void)
 {
     fprintf(stderr,
-        "unico [OPTIONS...] [QUANTITY FROM TO]...\n"
+        "unico [OPTIONS...] [QUANTITY [+/- TOLERANCE] FROM TO]...\n"
+        "unico [OPTIONS...] -a TO\n"
+        "unico [OPTIONS...] -b\n"
+        "unico [OPTIONS...] -e TO | -E TO\n"
         "\n"
         "Convert QUANTITY in FROM unit to TO unit.\n"
+        "A TOLERANCE, introduced by +/- or ±, is converted without offset.\n"
+        "Or summarize records of QUANTITY FROM read from standard input, in TO unit.\n"
+        "Or convert every quantity in text read from standard input to TO units.\n"
         "\n"
         "Options:\n"
+        "	-a, --aggregate=TO	Print count, sum, mean, minimum, maximum and\n"
+        "				percentiles of records read from standard\n"
+        "				input, in TO unit.\n"
+        "	-b, --batch		Convert records of QUANTITY FROM TO read from\n"
+        "				standard input, reloading FILE on SIGHUP.\n"
+        "	-c, --cache=ENTRIES	With -b, cache the results of up to ENTRIES\n"
+        "				distinct records.\n"
+        "	-d, --definitions=FILE	Load unit definitions from FILE.\n"
+        "	-e, --extract=TO	Rewrite quantities in text read from standard\n"
+        "				input in TO units: metric, imperial, or a\n"
+        "				comma separated list of units.\n"
+        "	-E, --annotate=TO	As --extract, but follow each quantity with\n"
+        "				its conversion in parentheses.\n"
         "	-h, --help		Show this help and exit.\n"
+        "	-j, --jobs=JOBS		Aggregate a file in JOBS threads.\n"
         "	-l, --list		List known units and exit.\n"
+        "	-t, --tolerant		Ignore case, white space, and degree and prime\n"
+        "				symbol variants in unit labels.\n"
+        "	-u, --uring		With -b, read and write through io_uring,\n"
+        "				if available.\n"
+        "	-x, --exact		Convert with exact rational factors where possible.\n"
         );
     exit(EXIT_SUCCESS);
 }
@@ -57,6 +143,8 @@ static void help(void)
 __attribute__((noreturn))
 static void list(void)
 {
+    locale();
+
 #define s(name) \
     printf("%ls.\n", name);
 
@@ -65,9 +153,132 @@ static void list(void)
     label_synonyms(name);
 
 #include "unit.hi"
+
+    const struct extension *ext = extension_get();
+    bool defined = false;
+
+    // Units that replace built-in units are listed as those.
+    for (uint32_t i = 0; ext && i < ext->units; ++i) {
+        if (!ext->replaces || ext->replaces[i] == PresentationUnitNone) {
+            printf(defined ? "\t" : "Defined.\n\t");
+            defined = true;
+            label_synonyms((enum unit)(PresentationUnitCount + i));
+        }
+    }
+
     exit(EXIT_SUCCESS);
 }
 
+/// Load unit definitions from file at @c path.
+static void define(const char *path)
+{
+    size_t line;
+    int r;
+
+    locale();
+
+    r = reload(path, &line);
+    if (r == -EINVAL) {
+        fprintf(stderr, "%s:%zu: Bad definition.\n", path, line);
+        exit(EXIT_FAILURE);
+    } else if (r) {
+        errno = -r;
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/// Command line options.
+struct options {
+    /// Convert with exact rational factors.
+    bool exact;
+    /// Match unit labels tolerantly.
+    bool tolerant;
+    /// Destination unit of aggregation, or NULL.
+    const char *aggregate;
+    /// Definitions file, or NULL.
+    const char *definitions;
+    /// Convert records read from standard input.
+    bool batch;
+    /// Read and write records through io_uring.
+    bool uring;
+    /// Destination units of extraction, or NULL.
+    const char *extract;
+    /// Annotate extracted quantities instead of rewriting them.
+    bool annotate;
+    /// Number of threads.
+    size_t jobs;
+    /// Number of results of records cached in batch conversion, or zero.
+    size_t cache;
+};
+
+/// Size of buffer for a rendered quantity.
+#define RENDER_MAX 256
+
+/// Render @c quantity of @c unit, with @c tolerance if it is not zero, into @c buffer of RENDER_MAX bytes.
+/// @return @c buffer, or NULL if the quantity cannot be rendered.
+static const char *render(double quantity, double tolerance, enum unit unit, char *buffer)
+{
+    int n = tolerance
+        ? unit_format_tolerance(quantity, tolerance, unit, buffer, RENDER_MAX)
+        : unit_format(quantity, unit, buffer, RENDER_MAX);
+
+    return n >= 0 && n < RENDER_MAX ? buffer : NULL;
+}
+
+/// Print conversion described by @c data to each of its destination units, to @c out.
+/// @return False if any conversion failed, as reported on standard error.
+static bool print(const struct parser_data *data, const struct options *options, FILE *out)
+{
+    double quantities[data->target_count];
+    double tolerances[data->target_count];
+    struct unit_conversion conversion = { 0 };
+    double value = 0;
+    char buffer[2][RENDER_MAX];
+    const char *in;
+
+    text(symbol_of_unit(data->from));
+    for (size_t i = 0; i < data->target_count; ++i) {
+        text(symbol_of_unit(data->targets[i]));
+    }
+    if (data->value_tolerance) {
+        text(L"±");
+    }
+
+    if (options->exact) {
+        in = render(data->value, data->value_tolerance, data->from, buffer[0]);
+        for (size_t i = 0; i < data->target_count; ++i) {
+            unit_conversion(data->from, data->targets[i], &conversion);
+            quantities[i] = unit_convert(&conversion, data->value);
+            tolerances[i] = unit_convert_tolerance(&conversion, data->value_tolerance);
+        }
+    } else {
+        base_to_unit(data->quantity, data->base, data->from, &value);
+        in = render(value, data->value_tolerance, data->from, buffer[0]);
+        base_to_units(data->quantity, data->base, data->targets, data->target_count, quantities);
+        for (size_t i = 0; i < data->target_count; ++i) {
+            tolerances[i] = 0;
+            base_to_unit_tolerance(data->tolerance, data->base, data->targets[i], &tolerances[i]);
+        }
+    }
+
+    bool converted = true;
+
+    for (size_t i = 0; i < data->target_count; ++i) {
+        bool compatible = !base_to_unit(data->quantity, data->base, data->targets[i], NULL);
+        const char *rendered = compatible ? render(quantities[i], tolerances[i], data->targets[i], buffer[1]) : NULL;
+
+        if (in && rendered) {
+            fprintf(out, "%s is %s\n", in, rendered);
+        } else {
+            fprintf(stderr, "Cannot convert '%ls' to '%ls'.\n", text(symbol_of_unit(data->from)), text(symbol_of_unit(data->targets[i])));
+            converted = false;
+        }
+    }
+
+    return converted;
+}
+
 /// Report failure.
 /// @return False if parsing failed.
 static bool report(enum parser_ret ret, const wchar_t *term)
@@ -78,17 +289,24 @@ static bool report(enum parser_ret ret, const wchar_t *term)
         case PARSE_COMPLETE:
             return true;
         case PARSE_INVALID_COMPOUND:
-            fprintf(stderr, "Incompatible unit '%ls'.\n", term);
+            fprintf(stderr, "Incompatible unit '%ls'.\n", text(term));
             break;
         default:
         case PARSE_INVALID_ARGUMENT:
             fprintf(stderr, "Internal error.\n");
             break;
         case PARSE_UNKNOWN_UNIT:
-            fprintf(stderr, "Unknown unit '%ls'.\n", term);
+        {
+            const wchar_t *suggestion = label_suggest(term);
+            if (suggestion) {
+                fprintf(stderr, "Unknown unit '%ls', did you mean '%ls'?\n", text(term), text(suggestion));
+            } else {
+                fprintf(stderr, "Unknown unit '%ls'.\n", text(term));
+            }
             break;
+        }
         case PARSE_INVALID_NUMBER:
-            fprintf(stderr, "Bad number '%ls'.\n", term);
+            fprintf(stderr, "Bad number '%ls'.\n", text(term));
             break;
     }
 
@@ -97,12 +315,13 @@ static bool report(enum parser_ret ret, const wchar_t *term)
 
 /// Process arguments.
 /// @return False if processing failed.
-static bool process(int argc, char **argv)
+static bool process(int argc, char **argv, const struct options *options)
 {
     struct parser *parser;
     enum parser_ret ret = PARSE_COMPLETE;
 
     parser = parser_new();
+    parser_tolerant(parser, options->tolerant);
 
     while (argc-- > 0) {
         char *arg;
@@ -120,17 +339,7 @@ static bool process(int argc, char **argv)
 
         ret = parser_add(parser, warg, &term, &data);
         if (ret == PARSE_COMPLETE) {
-            char *in = base_render(data.quantity, data.base, data.from);
-            char *out = base_render(data.quantity, data.base, data.to);
-
-            if (in && out) {
-                printf("%s is %s\n", in, out);
-            } else {
-                fprintf(stderr, "Cannot convert '%ls' to '%ls'.\n", symbol_of_unit(data.from), symbol_of_unit(data.to));
-            }
-
-            free(in);
-            free(out);
+            print(&data, options, stdout);
         }
 
         if (!report(ret, term)) {
@@ -151,24 +360,655 @@ static bool process(int argc, char **argv)
     return true;
 }
 
+/// Convert record @c line to a wide string in @c buffer of @c capacity, without trailing white space.
+/// @return Zero on success, negative otherwise.
+/// @return -ENOMEM If memory is exhausted.
+/// @return -EILSEQ If @c line is not valid in the current locale.
+static int widen(const char *line, wchar_t **buffer, size_t *capacity)
+{
+    size_t length = strlen(line) + 1;
+
+    if (length > *capacity) {
+        wchar_t *record = realloc(*buffer, length * sizeof(*record));
+        if (!record) {
+            return -ENOMEM;
+        }
+        *buffer = record;
+        *capacity = length;
+    }
+
+    length = mbstowcs(*buffer, line, length);
+    if (length == (size_t)-1) {
+        return -EILSEQ;
+    }
+
+    while (length && iswspace((*buffer)[length - 1])) {
+        (*buffer)[--length] = L'\0';
+    }
+
+    return 0;
+}
+
+/// Conversion of records read from standard input.
+struct batch {
+    /// Options.
+    const struct options *options;
+    /// Parser.
+    struct parser *parser;
+    /// Record, as wide string.
+    wchar_t *record;
+    /// Capacity of @c record.
+    size_t capacity;
+    /// Number of records rejected.
+    size_t rejected;
+    /// True if each result is written as soon as its record is read, as when records are read from a pipe.
+    bool flush;
+    /// Results.
+    FILE *out;
+    /// Results by record, or NULL.
+    struct cache *cache;
+    /// Extension, and epoch on entry, with which the cached results were converted.
+    const struct extension *extension;
+    uint64_t epoch;
+    /// Results of the record being converted, while a cache is used.
+    FILE *memory;
+    char *result;
+    size_t result_size;
+};
+
+/// Write the cached results of record @c line of batch @c b, if any, first emptying the cache if the definitions
+/// were replaced after its results were converted.
+/// @return True if the results were cached.
+static bool cached(struct batch *b, const char *line)
+{
+    const char *result;
+    size_t length;
+
+    if (!b->cache) {
+        return false;
+    }
+
+    if (extension_get() != b->extension || extension_epoch() != b->epoch) {
+        cache_clear(b->cache);
+        b->extension = extension_get();
+        b->epoch = extension_epoch();
+    }
+
+    result = cache_get(b->cache, line, strlen(line), &length);
+    if (result) {
+        fwrite(result, 1, length, b->out);
+    }
+
+    return result != NULL;
+}
+
+/// Convert record @c line of batch @c b, caching its results if every conversion succeeds.
+/// @return Zero, or negative if memory is exhausted.
+static int convert(struct batch *b, const char *line, size_t number)
+{
+    struct parser_data data;
+    enum parser_ret ret;
+    wchar_t *term = NULL;
+    int r;
+
+    r = widen(line, &b->record, &b->capacity);
+    if (r == -EILSEQ) {
+        fprintf(stderr, "%zu: Bad record.\n", number);
+        b->rejected++;
+        return 0;
+    } else if (r) {
+        return r;
+    }
+
+    ret = parser_add(b->parser, b->record, &term, &data);
+    if (ret == PARSE_COMPLETE && b->cache) {
+        rewind(b->memory);
+        bool converted = print(&data, b->options, b->memory);
+        off_t length = fflush(b->memory) ? -1 : ftello(b->memory);
+
+        if (length < 0) {
+            return -ENOMEM;
+        }
+        fwrite(b->result, 1, (size_t)length, b->out);
+        if (converted) {
+            cache_put(b->cache, line, strlen(line), b->result, (size_t)length);
+        }
+    } else if (ret == PARSE_COMPLETE) {
+        print(&data, b->options, b->out);
+    } else {
+        fprintf(stderr, "%zu: ", number);
+        if (ret == PARSE_AGAIN) {
+            fprintf(stderr, "Incomplete record.\n");
+        } else {
+            report(ret, term);
+        }
+        parser_reset(b->parser);
+        b->rejected++;
+    }
+
+    return 0;
+}
+
+/// Convert record @c line of batch @c context, with the definitions current when it is read.
+/// @return Zero, or negative if memory is exhausted.
+static int batch_record(void *context, char *line, size_t number)
+{
+    struct batch *b = context;
+    int r;
+
+    if (!line[strspn(line, " \t\r")]) {
+        // Blank.
+        return 0;
+    }
+
+    r = extension_enter();
+    if (r) {
+        return r;
+    }
+
+    r = cached(b, line) ? 0 : convert(b, line, number);
+
+    extension_leave();
+
+    if (b->flush) {
+        fflush(b->out);
+    }
+    return r;
+}
+
+/// Reload definitions from file @c arg on each SIGHUP, which the calling thread has blocked.
+static void *reloader(void *arg)
+{
+    const char *path = arg;
+    sigset_t set;
+    int sig;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+
+    while (!sigwait(&set, &sig)) {
+        struct reload_metrics m;
+        size_t line;
+        int r = reload(path, &line);
+
+        if (r == -EINVAL) {
+            fprintf(stderr, "%s:%zu: Bad definition.\n", path, line);
+        } else if (r) {
+            fprintf(stderr, "%s: %s\n", path, strerror(-r));
+        }
+
+        reload_metrics(&m);
+        fprintf(stderr, "%s: version %llu, %llu failed, built in %.3f ms, swapped in %.3f ms (max %.3f ms), "
+            "%zu bytes (peak %zu)\n", path, (unsigned long long)m.version, (unsigned long long)m.failures,
+            m.build_ns / 1e6, m.swap_ns / 1e6, m.swap_max_ns / 1e6, m.bytes, m.peak_bytes);
+    }
+
+    return NULL;
+}
+
+/// Convert records read from standard input, reloading definitions on SIGHUP if they were loaded from a file.
+/// @return False if any record was rejected, or if input could not be read.
+static bool batch(const struct options *options)
+{
+    struct batch b = { .options = options, .parser = parser_new() };
+    pthread_t thread;
+    struct stat st;
+    sigset_t set;
+    int r;
+
+    // Records are likely to contain text outside ASCII, and the reloader must not race to initialize locale.
+    locale();
+
+    if (options->definitions) {
+        sigemptyset(&set);
+        sigaddset(&set, SIGHUP);
+        pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+        if (pthread_create(&thread, NULL, reloader, (void *)options->definitions)) {
+            fprintf(stderr, "Cannot reload definitions.\n");
+        }
+    }
+
+    if (b.parser) {
+        parser_tolerant(b.parser, options->tolerant);
+    }
+
+    // Results of a record are cached as written, so repeated records are not parsed or rendered again.
+    r = options->cache ? cache_new(options->cache, &b.cache) : 0;
+    b.memory = b.cache ? open_memstream(&b.result, &b.result_size) : NULL;
+
+    // Records of a regular file are not awaited, so results are written in blocks.
+    b.flush = fstat(STDIN_FILENO, &st) || !S_ISREG(st.st_mode);
+
+    // Results are written through io_uring if it is available, otherwise to standard output.
+    b.out = options->uring ? record_write_async(STDOUT_FILENO) : NULL;
+    b.out = b.out ? b.out : stdout;
+
+    r = r ? r
+        : !b.parser || (b.cache && !b.memory) ? -ENOMEM
+        : options->uring ? record_read_async(STDIN_FILENO, batch_record, &b)
+        : record_read(STDIN_FILENO, batch_record, &b);
+
+    if (r) {
+        errno = -r;
+        perror("stdin");
+    }
+
+    if (b.out != stdout && fclose(b.out)) {
+        perror("stdout");
+        r = -EIO;
+    }
+
+    if (b.cache) {
+        struct cache_metrics m;
+
+        cache_metrics(b.cache, &m);
+        fprintf(stderr, "cache: %llu hits, %llu misses (%.1f%% hit), %llu evicted, %zu entries\n",
+            (unsigned long long)m.hits, (unsigned long long)m.misses,
+            m.hits + m.misses ? 100.0 * (double)m.hits / (double)(m.hits + m.misses) : 0,
+            (unsigned long long)m.evictions, m.entries);
+    }
+
+    if (b.memory) {
+        fclose(b.memory);
+    }
+    free(b.result);
+    cache_delete(b.cache);
+    parser_delete(b.parser);
+    free(b.record);
+    return !r && !b.rejected;
+}
+
+/// Destination units of extraction for each system of units.
+struct system {
+    /// Name.
+    const char *name;
+    /// Comma separated list of units, one for each base unit.
+    const wchar_t *units;
+    /// True if the units of the system are metric, as by metric(), otherwise those that are not.
+    bool metric;
+};
+
+static const struct system systems[] = {
+    { "metric", L"m,m^2,L,kg,°C,kPa,°", true },
+    { "imperial", L"'\",ft^2,pt,lb,°F,psi,°", false },
+};
+
+/// @return True if @c unit is a power of ten times its base unit, as the units of the metric system are.
+static bool metric(enum unit unit)
+{
+    enum base base;
+    double exponent = log10(unit_to_base(1, unit, &base) - unit_to_base(0, unit, &base));
+
+    return fabs(exponent - round(exponent)) < 1e-9;
+}
+
+/// Extraction of quantities from text read from standard input.
+struct extraction {
+    /// Extractor.
+    struct extractor *extractor;
+    /// Destination unit of each base, or PresentationUnitNone.
+    enum unit *destination;
+    /// Number of bases.
+    size_t bases;
+    /// Annotate quantities instead of rewriting them.
+    bool annotate;
+    /// System of units converted to, or NULL if units were listed.
+    const struct system *system;
+};
+
+/// Write record @c line of @c length bytes of extraction @c e, with each quantity that has a destination unit of its
+/// base, and is not already in that unit, converted. The line terminator is written only if the record has one.
+static void extract_record(struct extraction *e, const char *line, size_t length)
+{
+    size_t size = length && line[length - 1] == '\n' ? length - 1 : length;
+    size_t offset = 0;
+    size_t written = 0;
+    struct extract_match m;
+    char buffer[RENDER_MAX];
+
+    while (extractor_find(e->extractor, line, size, &offset, &m)) {
+        enum unit to = (size_t)m.base < e->bases ? e->destination[m.base] : PresentationUnitNone;
+        double value = 0;
+        double tolerance = 0;
+        // A tolerance is converted with its quantity, without offset.
+        // Quantities already in a unit of the system converted to are left alone.
+        bool kept = to == m.unit || (e->system && metric(m.unit) == e->system->metric);
+        const char *rendered = to != PresentationUnitNone && !kept
+            && !base_to_unit(m.quantity, m.base, to, &value)
+            && !base_to_unit_tolerance(m.tolerance, m.base, to, &tolerance)
+            ? render(value, tolerance, to, buffer)
+            : NULL;
+
+        if (rendered) {
+            fwrite(line + written, 1, (e->annotate ? m.end : m.begin) - written, stdout);
+            fputs(e->annotate ? " (" : "", stdout);
+            fputs(rendered, stdout);
+            fputs(e->annotate ? ")" : "", stdout);
+            written = m.end;
+        }
+    }
+
+    fwrite(line + written, 1, length - written, stdout);
+}
+
+/// Convert every quantity in text read from standard input, line by line.
+/// @return False if a destination unit is unknown, or if input could not be read.
+static bool extract(const struct options *options)
+{
+    const struct extension *ext = extension_get();
+    struct extraction e = { .bases = BaseUnitCount + (ext ? ext->bases : 0), .annotate = options->annotate };
+    wchar_t *to = NULL;
+    wchar_t *state;
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    bool ok = true;
+    int r;
+
+    // Text is likely to contain text outside ASCII, and is rendered with symbols outside ASCII.
+    locale();
+
+    for (size_t i = 0; i < sizeof(systems) / sizeof(*systems); ++i) {
+        e.system = !e.system && !strcmp(options->extract, systems[i].name) ? &systems[i] : e.system;
+    }
+
+    to = e.system ? wcsdup(e.system->units) : NULL;
+    to = to ? to : str_to_wcs(options->extract);
+    if (!to) {
+        perror(options->extract);
+        return false;
+    }
+
+    e.destination = malloc(e.bases * sizeof(*e.destination));
+    for (size_t i = 0; e.destination && i < e.bases; ++i) {
+        e.destination[i] = PresentationUnitNone;
+    }
+
+    // The first destination unit of each base is used.
+    for (wchar_t *label = wcstok(to, L",", &state); ok && e.destination && label; label = wcstok(NULL, L",", &state)) {
+        wchar_t *p;
+        enum unit unit = options->tolerant ? label_lookup_tolerant(label, &p) : label_lookup(label, &p);
+        enum base base;
+
+        ok = !*p && symbol_of_unit(unit) ? true : report(PARSE_UNKNOWN_UNIT, label);
+        unit_to_base(0, unit, &base);
+        if (ok && (size_t)base < e.bases && e.destination[base] == PresentationUnitNone) {
+            e.destination[base] = unit;
+        }
+    }
+
+    e.extractor = ok && e.destination ? extractor_new() : NULL;
+    r = !ok || e.extractor ? 0 : -ENOMEM;
+
+    // Lines are read with their terminators, so that a last line without one is written without one.
+    while (ok && e.extractor && (length = getline(&line, &capacity, stdin)) > 0) {
+        extract_record(&e, line, (size_t)length);
+    }
+    r = r || !ok || !e.extractor || feof(stdin) ? r : -errno;
+
+    if (r) {
+        errno = -r;
+        perror("stdin");
+    }
+
+    extractor_delete(e.extractor);
+    free(e.destination);
+    free(line);
+    free(to);
+    return ok && !r;
+}
+
+/// Aggregation of records, by one thread.
+struct aggregation {
+    /// Destination unit label.
+    const wchar_t *to;
+    /// Destination unit, and its base.
+    enum unit unit;
+    enum base base;
+    /// Parser.
+    struct parser *parser;
+    /// Record, as wide string.
+    wchar_t *record;
+    /// Capacity of @c record.
+    size_t capacity;
+    /// Summary, in the destination unit.
+    struct aggregate aggregate;
+    /// Number of records rejected.
+    size_t rejected;
+};
+
+/// Add record @c line to aggregation @c context.
+/// @return Zero, or negative if memory is exhausted.
+static int aggregate_record(void *context, char *line, size_t number)
+{
+    struct aggregation *a = context;
+    wchar_t to[wcslen(a->to) + 1];
+    struct parser_data data;
+    enum parser_ret ret;
+    wchar_t *term = NULL;
+    double quantity;
+    int r;
+
+    if (!line[strspn(line, " \t\r")]) {
+        // Blank.
+        return 0;
+    }
+
+    r = widen(line, &a->record, &a->capacity);
+    if (r == -EILSEQ) {
+        fprintf(stderr, "%zu: Bad record.\n", number);
+        a->rejected++;
+        return 0;
+    } else if (r) {
+        return r;
+    }
+
+    wcscpy(to, a->to);
+    ret = parser_add(a->parser, a->record, &term, &data);
+    ret = ret == PARSE_AGAIN ? parser_add(a->parser, to, &term, &data) : ret;
+
+    // Quantities are summarized in the destination unit, so that quantiles are accurate relative to the values printed,
+    // which for an affine unit such as °C may be small or negative where the base unit is not.
+    if (ret == PARSE_COMPLETE && data.base == a->base && !base_to_unit(data.quantity, data.base, a->unit, &quantity) &&
+        !aggregate_add(&a->aggregate, quantity, data.base)) {
+        return 0;
+    }
+
+    fprintf(stderr, "%zu: ", number);
+    if (ret == PARSE_COMPLETE && data.base == a->base) {
+        fprintf(stderr, "Bad quantity.\n");
+    } else if (ret == PARSE_COMPLETE) {
+        fprintf(stderr, "Cannot convert '%ls' to '%ls'.\n", text(symbol_of_unit(data.from)), text(a->to));
+    } else if (ret == PARSE_AGAIN) {
+        fprintf(stderr, "Incomplete record.\n");
+    } else {
+        report(ret, term);
+    }
+
+    parser_reset(a->parser);
+    a->rejected++;
+    return 0;
+}
+
+/// Print statistic @c name, @c quantity of @c unit, in %g if it cannot be rendered.
+static void statistic(const char *name, double quantity, enum unit unit)
+{
+    char buffer[RENDER_MAX];
+    const char *rendered = render(quantity, 0, unit, buffer);
+
+    if (rendered) {
+        printf("%s %s\n", name, rendered);
+    } else {
+        printf("%s %g %ls\n", name, quantity, text(symbol_of_unit(unit)));
+    }
+}
+
+/// Quantile printed by aggregate.
+struct quantile {
+    /// Name.
+    const char *name;
+    /// Quantile.
+    double q;
+};
+
+static const struct quantile quantiles[] = {
+    { "p50", 0.5 },
+    { "p99", 0.99 },
+    { "p999", 0.999 },
+};
+
+/// Aggregate records read from standard input.
+/// @return False if any record was rejected, or if input could not be read.
+static bool aggregate(const struct options *options)
+{
+    wchar_t *to;
+    wchar_t *p;
+    enum unit unit;
+    enum base base;
+    size_t rejected = 0;
+    int r;
+
+    // Records are likely to contain text outside ASCII, and threads must not race to initialize locale.
+    locale();
+
+    to = str_to_wcs(options->aggregate);
+    if (!to) {
+        perror(options->aggregate);
+        return false;
+    }
+
+    unit = options->tolerant ? label_lookup_tolerant(to, &p) : label_lookup(to, &p);
+    if (*p || !symbol_of_unit(unit)) {
+        report(PARSE_UNKNOWN_UNIT, to);
+        free(to);
+        return false;
+    }
+    unit_to_base(0, unit, &base);
+
+    // Each aggregation has a sketch, too large for the stack in number.
+    struct aggregation *aggregations = calloc(options->jobs, sizeof(*aggregations));
+    void **contexts = calloc(options->jobs, sizeof(*contexts));
+    if (!aggregations || !contexts) {
+        perror("calloc");
+        free(aggregations);
+        free(contexts);
+        free(to);
+        return false;
+    }
+
+    for (size_t t = 0; t < options->jobs; ++t) {
+        aggregations[t] = (struct aggregation){ .to = to, .unit = unit, .base = base, .parser = parser_new() };
+        aggregate_init(&aggregations[t].aggregate);
+        parser_tolerant(aggregations[t].parser, options->tolerant);
+        contexts[t] = &aggregations[t];
+    }
+
+    r = record_read_parallel(STDIN_FILENO, options->jobs, aggregate_record, contexts);
+
+    struct aggregate *total = &aggregations[0].aggregate;
+    for (size_t t = 0; t < options->jobs; ++t) {
+        if (t) {
+            aggregate_merge(total, &aggregations[t].aggregate);
+        }
+        rejected += aggregations[t].rejected;
+        parser_delete(aggregations[t].parser);
+        free(aggregations[t].record);
+    }
+
+    if (r) {
+        errno = -r;
+        perror("stdin");
+    }
+
+    text(symbol_of_unit(unit));
+    printf("count %zu\n", total->count);
+
+    if (total->count) {
+        // Quantities were converted individually, so the sum is that of the quantities in TO even for affine units.
+        statistic("sum", aggregate_sum(total), unit);
+        statistic("mean", aggregate_mean(total), unit);
+        statistic("min", total->min, unit);
+        statistic("max", total->max, unit);
+
+        for (size_t i = 0; i < sizeof(quantiles) / sizeof(*quantiles); ++i) {
+            statistic(quantiles[i].name, aggregate_quantile(total, quantiles[i].q), unit);
+        }
+    }
+
+    free(aggregations);
+    free(contexts);
+    free(to);
+    return !r && !rejected;
+}
+
 int main(int argc, char **argv)
 {
     struct option longopts[] = {
+        { "aggregate", required_argument, NULL, 'a' },
+        { "batch", no_argument, NULL, 'b' },
+        { "cache", required_argument, NULL, 'c' },
+        { "definitions", required_argument, NULL, 'd' },
+        { "extract", required_argument, NULL, 'e' },
+        { "annotate", required_argument, NULL, 'E' },
         { "help", no_argument, NULL, 'h' },
+        { "jobs", required_argument, NULL, 'j' },
         { "list", no_argument, NULL, 'l' },
+        { "tolerant", no_argument, NULL, 't' },
+        { "uring", no_argument, NULL, 'u' },
+        { "exact", no_argument, NULL, 'x' },
         { NULL, 0, NULL, 0 }
     };
 
+    struct options options = { false, false, NULL, NULL, false, false, NULL, false, 1, 0 };
     int ch;
 
-    setlocale(LC_ALL, "");
+    if (!plain("LC_NUMERIC") || !plain("LC_MESSAGES")) {
+        locale();
+    }
 
-    while ((ch = getopt_long(argc, argv, "hl", longopts, NULL)) != -1) {
+    while ((ch = getopt_long(argc, argv, "a:bc:d:e:E:hj:ltux", longopts, NULL)) != -1) {
         switch (ch) {
+            case 'a':
+                options.aggregate = optarg;
+                break;
+            case 'b':
+                options.batch = true;
+                break;
+            case 'c':
+                options.cache = strtoul(optarg, NULL, 10);
+                if (!options.cache) {
+                    synopsis();
+                }
+                break;
+            case 'd':
+                define(optarg);
+                options.definitions = optarg;
+                break;
+            case 'e':
+            case 'E':
+                options.extract = optarg;
+                options.annotate = ch == 'E';
+                break;
             case 'h':
                 help();
+            case 'j':
+                options.jobs = strtoul(optarg, NULL, 10);
+                if (!options.jobs) {
+                    synopsis();
+                }
+                break;
             case 'l':
                 list();
+            case 't':
+                options.tolerant = true;
+                break;
+            case 'u':
+                options.uring = true;
+                break;
+            case 'x':
+                options.exact = true;
+                break;
             default:
                 synopsis();
         }
@@ -177,11 +1017,33 @@ int main(int argc, char **argv)
     argc -= optind;
     argv += optind;
 
+    if (options.aggregate) {
+        // Option -x does not apply to aggregation.
+        if (argc || options.batch || options.extract || options.exact) {
+            synopsis();
+        }
+        exit(aggregate(&options) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if (options.extract) {
+        if (argc || options.batch) {
+            synopsis();
+        }
+        exit(extract(&options) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if (options.batch) {
+        if (argc) {
+            synopsis();
+        }
+        exit(batch(&options) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     if (argc == 0) {
         synopsis();
     }
 
-    if (!process(argc, argv)) {
+    if (!process(argc, argv, &options)) {
         exit(EXIT_FAILURE);
     }
 }
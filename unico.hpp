@@ -0,0 +1,220 @@
+#pragma once
+
+/// Header-only C++ front end.
+/// Units and labels are resolved at compile time from unit.hi and label.hi, using the C definitions of
+/// enum unit and enum base.
+
+extern "C" {
+#include "unit.h"
+}
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace unico {
+
+namespace detail {
+
+/// Relationship of unit to base unit, such that base = (X + offset) * scale.
+struct conversion {
+    /// Symbol, or nullptr if unit has no conversion.
+    const wchar_t *symbol;
+    /// Base unit.
+    enum base base;
+    /// Multiplier.
+    double scale;
+    /// Offset.
+    double offset;
+};
+
+/// @return Conversion of @c unit_.
+constexpr conversion conversion_of(enum unit unit_)
+{
+    switch (unit_) {
+#define u(symbol, name, base_, scale)         case name: return { symbol, base_, scale, 0 };
+#define c(symbol, name, base_, scale, offset) case name: return { symbol, base_, scale, offset };
+#include "unit.hi"
+        default:
+            return { nullptr, BaseUnitNone, 1, 0 };
+    }
+}
+
+struct label {
+    /// Label.
+    const wchar_t *text;
+    /// Unit.
+    enum unit unit;
+};
+
+/// Lookup table used for parsing user description of a unit.
+inline constexpr label labels[] = {
+#define l(label_, unit_) { label_, unit_ },
+#include "label.hi"
+};
+
+/// Value of decode for a sequence that is truncated, which is no code point.
+inline constexpr char32_t invalid = 0xffffffff;
+
+/// @return Code point at @c s[i] for UTF-8 @c s of @c length code units, or @c invalid if the sequence ends early;
+/// @c i is advanced past the code point.
+constexpr char32_t decode(const char *s, std::size_t length, std::size_t &i)
+{
+    unsigned char ch = static_cast<unsigned char>(s[i++]);
+    if (ch < 0x80) {
+        return ch;
+    }
+
+    int n = ch >= 0xf0 ? 3 : ch >= 0xe0 ? 2 : 1;
+    char32_t cp = ch & (0x3f >> n);
+    while (n--) {
+        unsigned char next = i < length ? static_cast<unsigned char>(s[i]) : 0;
+        if ((next & 0xc0) != 0x80) {
+            return invalid;
+        }
+        cp = (cp << 6) | (next & 0x3f);
+        ++i;
+    }
+    return cp;
+}
+
+/// @return Code point at @c s[i] for wide @c s; @c i is advanced past the code point.
+constexpr char32_t decode(const wchar_t *s, std::size_t, std::size_t &i)
+{
+    return static_cast<char32_t>(s[i++]);
+}
+
+/// @return True if @c text equals @c s of @c length code units.
+template <typename Char>
+constexpr bool equal(const wchar_t *text, const Char *s, std::size_t length)
+{
+    std::size_t i = 0;
+    for (; *text && i < length; ++text) {
+        if (static_cast<char32_t>(*text) != decode(s, length, i)) {
+            return false;
+        }
+    }
+    return !*text && i == length;
+}
+
+/// String literal usable as a template argument.
+template <typename Char, std::size_t N>
+struct fixed_string {
+    Char s[N] {};
+
+    constexpr fixed_string(const Char (&str)[N])
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            s[i] = str[i];
+        }
+    }
+};
+
+} // namespace detail
+
+/// @return Unit with label @c s of @c length code units.
+/// @throw std::invalid_argument If label is unknown; this is a compile error in constant evaluation.
+template <typename Char>
+constexpr enum unit unit_of(const Char *s, std::size_t length)
+{
+    for (const auto &label : detail::labels) {
+        if (detail::equal(label.text, s, length)) {
+            return label.unit;
+        }
+    }
+    throw std::invalid_argument("Unknown unit");
+}
+
+/// @return Unit with label @c s.
+template <typename Char, std::size_t N>
+constexpr enum unit unit_of(const Char (&s)[N])
+{
+    return unit_of(s, N - 1);
+}
+
+/// @return Symbol of @c unit_, or nullptr.
+constexpr const wchar_t *symbol_of(enum unit unit_)
+{
+    return detail::conversion_of(unit_).symbol;
+}
+
+/// @return Base unit of @c unit_.
+constexpr enum base base_of(enum unit unit_)
+{
+    return detail::conversion_of(unit_).base;
+}
+
+/// @return True if @c from can be converted to @c to.
+constexpr bool compatible(enum unit from, enum unit to)
+{
+    return symbol_of(from) && symbol_of(to) && base_of(from) == base_of(to);
+}
+
+/// Conversion from @c From to @c To, fused into a single multiply-add: To = From * multiplier + addend.
+template <enum unit From, enum unit To>
+struct factor {
+    static_assert(compatible(From, To), "Incompatible units.");
+
+    static constexpr double multiplier = detail::conversion_of(From).scale / detail::conversion_of(To).scale;
+    static constexpr double addend = detail::conversion_of(From).offset * multiplier - detail::conversion_of(To).offset;
+};
+
+/// @return @c quantity of @c From converted to @c To.
+template <enum unit From, enum unit To>
+constexpr double convert(double quantity)
+{
+    return quantity * factor<From, To>::multiplier + factor<From, To>::addend;
+}
+
+/// @return @c quantity of @c from converted to @c to, or NaN if the units are incompatible.
+constexpr double convert(double quantity, enum unit from, enum unit to)
+{
+    if (!compatible(from, to)) {
+        return NAN;
+    }
+
+    detail::conversion f = detail::conversion_of(from);
+    detail::conversion t = detail::conversion_of(to);
+    return (quantity + f.offset) * f.scale / t.scale - t.offset;
+}
+
+/// Strongly typed quantity.
+template <enum unit Unit>
+struct quantity {
+    static_assert(symbol_of(Unit), "Unit has no conversion.");
+
+    static constexpr enum unit unit = Unit;
+
+    double value;
+
+    constexpr explicit quantity(double value_) : value(value_) {}
+};
+
+static_assert(sizeof(quantity<PresentationUnitMetre>) == sizeof(double));
+
+/// @return @c q converted to unit @c To.
+template <enum unit To, enum unit From>
+constexpr quantity<To> quantity_cast(quantity<From> q)
+{
+    return quantity<To>(convert<From, To>(q.value));
+}
+
+#if __cplusplus >= 202002L
+
+/// @return @c quantity converted between units given by labels, e.g. @c convert<"°F", "K">(x).
+template <detail::fixed_string From, detail::fixed_string To>
+constexpr double convert(double quantity)
+{
+    return convert<unit_of(From.s), unit_of(To.s)>(quantity);
+}
+
+/// @return Unit given by label, e.g. @c quantity<"psi"_unit>.
+template <detail::fixed_string S>
+consteval enum unit operator""_unit()
+{
+    return unit_of(S.s);
+}
+
+#endif
+
+} // namespace unico
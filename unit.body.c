@@ -1,49 +1,135 @@
+/// Relationship of unit to base unit.
+enum kind {
+    /// No conversion possible.
+    KindNone,
+    /// base = X * scale.
+    KindLinear,
+    /// base = (X + offset) * scale.
+    KindAffine,
+};
+
+// Struct-of-arrays unit tables, indexed by enum unit.
+// PresentationUnitNone and PresentationUnitUnknown are identity conversions of kind KindNone.
+
+/// Unit symbols.
+static const wchar_t *const symbols[PresentationUnitCount] = {
+#define u(symbol, name, base_, scale)            [name] = symbol ,
+#define c(symbol, name, base_, scale, offset)    [name] = symbol ,
+#include "unit.hi"
+};
+
+/// Base of unit.
+static const enum base bases[PresentationUnitCount] = {
+#define u(symbol, name, base_, scale)            [name] = base_ ,
+#define c(symbol, name, base_, scale, offset)    [name] = base_ ,
+#include "unit.hi"
+};
+
+/// Multiplier from unit to base unit.
+static const double scales[PresentationUnitCount] = {
+    [PresentationUnitNone] = 1,
+    [PresentationUnitUnknown] = 1,
+#define u(symbol, name, base_, scale)            [name] = scale ,
+#define c(symbol, name, base_, scale, offset)    [name] = scale ,
+#include "unit.hi"
+};
+
+/// Offset added to quantity before scaling to base unit.
+static const double offsets[PresentationUnitCount] = {
+#define u(symbol, name, base_, scale)            [name] = 0 ,
+#define c(symbol, name, base_, scale, offset)    [name] = offset ,
+#include "unit.hi"
+};
+
+/// Multiplier from unit to base unit, as written in unit.hi.
+static const char *const scale_texts[PresentationUnitCount] = {
+#define u(symbol, name, base_, scale)            [name] = #scale ,
+#define c(symbol, name, base_, scale, offset)    [name] = #scale ,
+#include "unit.hi"
+};
+
+/// Offset added to quantity before scaling to base unit, as written in unit.hi.
+static const char *const offset_texts[PresentationUnitCount] = {
+#define u(symbol, name, base_, scale)            [name] = "0" ,
+#define c(symbol, name, base_, scale, offset)    [name] = #offset ,
+#include "unit.hi"
+};
+
+/// Kind of unit.
+static const unsigned char kinds[PresentationUnitCount] = {
+#define u(symbol, name, base_, scale)            [name] = KindLinear ,
+#define c(symbol, name, base_, scale, offset)    [name] = KindAffine ,
+#include "unit.hi"
+};
+
+/// @return Table index of @c unit, or that of PresentationUnitUnknown if @c unit is out of range.
+static size_t index_of(enum unit unit)
+{
+    return (size_t)unit < PresentationUnitCount ? (size_t)unit : (size_t)PresentationUnitUnknown;
+}
+
+/// @return True if @c unit is defined, or replaced, by the current extension, with @c ext and its table index @c i.
+static bool extended(enum unit unit, const struct extension **ext, size_t *i)
+{
+    size_t n = (size_t)unit;
+
+    *ext = extension_get();
+    n = n < PresentationUnitCount && *ext && (*ext)->replacement && (*ext)->replacement[n]
+        ? PresentationUnitCount + (*ext)->replacement[n] - 1 : n;
+    *i = n - PresentationUnitCount;
+    return n >= PresentationUnitCount && *ext && *i < (*ext)->units;
+}
+
+/// @return True if @c unit is built-in and not replaced by the current extension.
+static bool builtin(enum unit unit)
+{
+    const struct extension *ext;
+    size_t i;
+
+    return (size_t)unit < PresentationUnitCount && !extended(unit, &ext, &i);
+}
+
 const wchar_t *symbol_of_unit(enum unit unit)
 {
-    switch (unit) {
-        case PresentationUnitNone:
-        case PresentationUnitUnknown:
-            break;
+    const struct extension *ext;
+    size_t i;
 
-#define u(symbol, name, base_, scale)            case name : return symbol ;
-#define c(symbol, name, base_, tobase, frombase) case name : return symbol ;
-#include "unit.hi"
+    if (extended(unit, &ext, &i)) {
+        return ext->strings + ext->symbol[i];
     }
 
-    return NULL;
+    return symbols[index_of(unit)];
 }
 
 double unit_to_base(double quantity, enum unit unit, enum base *base)
 {
-    double X = quantity;
-
-    switch (unit) {
-        case PresentationUnitNone:
-        case PresentationUnitUnknown:
-            *base = BaseUnitNone;
-            break;
+    const struct extension *ext;
+    size_t i;
 
-#define u(symbol, name, base_, scale)            case name : *base = base_ ; X *= scale  ; break ;
-#define c(symbol, name, base_, tobase, frombase) case name : *base = base_ ; X  = tobase ; break ;
-#include "unit.hi"
+    if (extended(unit, &ext, &i)) {
+        *base = (enum base)ext->base[i];
+        return (quantity + ext->offset[i]) * ext->scale[i];
     }
 
-    return X;
+    i = index_of(unit);
+    *base = bases[i];
+    return (quantity + offsets[i]) * scales[i];
 }
 
 int base_to_unit(double quantity, enum base base, enum unit unit, double *quantity_out)
 {
-    double X = quantity;
-    int r = -EPERM;
-
-    switch (unit) {
-        case PresentationUnitNone:
-        case PresentationUnitUnknown:
-            break;
+    const struct extension *ext;
+    size_t i;
+    double X;
+    int r;
 
-#define u(symbol, name, base_, scale)            case name : if (base == base_) { X /= scale   ; r = 0; } break ;
-#define c(symbol, name, base_, tobase, frombase) case name : if (base == base_) { X  = frombase; r = 0; } break ;
-#include "unit.hi"
+    if (extended(unit, &ext, &i)) {
+        r = (enum base)ext->base[i] == base ? 0 : -EPERM;
+        X = quantity / ext->scale[i] - ext->offset[i];
+    } else {
+        i = index_of(unit);
+        r = (kinds[i] != KindNone && bases[i] == base) ? 0 : -EPERM;
+        X = quantity / scales[i] - offsets[i];
     }
 
     if (quantity_out && !r) {
@@ -53,27 +139,737 @@ int base_to_unit(double quantity, enum base base, enum unit unit, double *quanti
     return r;
 }
 
-char *base_render(double quantity, enum base base, enum unit unit)
+/// @return Multiplier from @c unit to its base unit, and the base in @c base.
+static double scale_of(enum unit unit, enum base *base)
+{
+    const struct extension *ext;
+    size_t i;
+
+    if (extended(unit, &ext, &i)) {
+        *base = (enum base)ext->base[i];
+        return ext->scale[i];
+    }
+
+    i = index_of(unit);
+    *base = bases[i];
+    return scales[i];
+}
+
+double unit_to_base_tolerance(double tolerance, enum unit unit, enum base *base)
+{
+    return fabs(tolerance * scale_of(unit, base));
+}
+
+int base_to_unit_tolerance(double tolerance, enum base base, enum unit unit, double *tolerance_out)
+{
+    enum base unit_base;
+    double scale = scale_of(unit, &unit_base);
+    int r = base_to_unit(0, base, unit, NULL);
+
+    if (tolerance_out && !r) {
+        *tolerance_out = fabs(tolerance / scale);
+    }
+
+    return r;
+}
+
+size_t base_units(enum base base, enum unit *units, size_t size)
+{
+    const struct extension *ext = extension_get();
+    size_t n = 0;
+
+    // Units of a base are listed together in unit.hi, under one section.
+    for (size_t i = PresentationUnitUnknown + 1; i < PresentationUnitCount; ++i) {
+        if (bases[i] == base && n++ < size) {
+            units[n - 1] = (enum unit)i;
+        }
+    }
+
+    // Units that replace built-in units are listed as those.
+    for (size_t i = 0; ext && i < ext->units; ++i) {
+        if ((!ext->replaces || ext->replaces[i] == PresentationUnitNone) && (enum base)ext->base[i] == base
+            && n++ < size) {
+            units[n - 1] = (enum unit)(PresentationUnitCount + i);
+        }
+    }
+
+    return n;
+}
+
+int base_to_units(double quantity, enum base base, const enum unit *units, size_t count, double *out)
+{
+    int r = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (base_to_unit(quantity, base, units[i], &out[i])) {
+            out[i] = NAN;
+            r = -EPERM;
+        }
+    }
+
+    return r;
+}
+
+/// Rational number.
+struct rational {
+    /// Numerator.
+    __int128 num;
+    /// Denominator, positive.
+    __int128 den;
+};
+
+/// Largest integer such that it and all smaller integers are exactly representable as double.
+#define EXACT_MAX ((__int128)1 << 53)
+
+/// @return Greatest common divisor of @c a and @c b.
+static __int128 gcd(__int128 a, __int128 b)
+{
+    a = a < 0 ? -a : a;
+
+    while (b) {
+        __int128 t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+/// @return True if @c a * @c b is representable, stored in @c out.
+static bool mul(__int128 a, __int128 b, __int128 *out)
+{
+    return !__builtin_mul_overflow(a, b, out);
+}
+
+/// Reduce @c r to lowest terms.
+/// @return True, for use in expressions.
+static bool reduce(struct rational *r)
+{
+    __int128 g = gcd(r->num, r->den);
+
+    r->num /= g;
+    r->den /= g;
+    return true;
+}
+
+/// Parse decimal number, with optional fraction and exponent, at @c *s.
+/// @return True on success, with @c r updated and @c s advanced.
+static bool parse_decimal(const char **s, struct rational *r)
+{
+    const char *p = *s;
+    bool negative = *p == '-';
+    int digits = 0;
+    int exponent = 0;
+
+    p += negative;
+    r->num = 0;
+    r->den = 1;
+
+    for (bool fraction = false; digits <= 36 && ((*p >= '0' && *p <= '9') || (*p == '.' && !fraction)); ++p) {
+        if (*p == '.') {
+            fraction = true;
+        } else {
+            r->num = r->num * 10 + (*p - '0');
+            exponent -= fraction;
+            digits++;
+        }
+    }
+
+    if (*p == 'e' || *p == 'E') {
+        char *end;
+        exponent += (int)strtol(p + 1, &end, 10);
+        p = end;
+    }
+
+    // Keep numerator and denominator within 10^36.
+    if (!digits || digits > 36 || digits + exponent > 36 || exponent < -36) {
+        return false;
+    }
+
+    for (; exponent; exponent += exponent < 0 ? 1 : -1) {
+        *(exponent < 0 ? &r->den : &r->num) *= 10;
+    }
+
+    r->num = negative ? -r->num : r->num;
+    *s = p;
+    return reduce(r);
+}
+
+/// Parse exact rational @c text of form "DECIMAL" or "DECIMAL / DECIMAL".
+/// @return True on success, with @c r updated.
+static bool parse_rational(const char *text, struct rational *r)
+{
+    struct rational divisor = { 1, 1 };
+    bool ok;
+
+    ok = parse_decimal(&text, r);
+    text += strspn(text, " ");
+
+    if (ok && *text == '/') {
+        text += 1 + strspn(text + 1, " ");
+        ok = parse_decimal(&text, &divisor) && divisor.num;
+    }
+
+    return ok
+        && !*text
+        && mul(r->num, divisor.den, &r->num)
+        && mul(r->den, divisor.num, &r->den)
+        && reduce(r);
+}
+
+/// @return True if @c a * @c b is representable, stored in @c out.
+static bool rational_mul(struct rational a, struct rational b, struct rational *out)
+{
+    return mul(a.num, b.num, &out->num) && mul(a.den, b.den, &out->den) && reduce(out);
+}
+
+/// @return True if @c a - @c b is representable, stored in @c out.
+static bool rational_sub(struct rational a, struct rational b, struct rational *out)
+{
+    __int128 x;
+    __int128 y;
+
+    return mul(a.num, b.den, &x)
+        && mul(b.num, a.den, &y)
+        && !__builtin_sub_overflow(x, y, &out->num)
+        && mul(a.den, b.den, &out->den)
+        && reduce(out);
+}
+
+/// @return True if numerator and denominator of @c r are exactly representable as double.
+static bool representable(struct rational r)
+{
+    return r.num < EXACT_MAX && -r.num < EXACT_MAX && r.den < EXACT_MAX;
+}
+
+/// Fuse the conversion from built-in unit @c from to built-in unit @c to, as to = X * multiplier + addend.
+/// @return True if the scales and offsets of both units are exact rationals and the fused conversion is
+/// representable.
+static bool rational_conversion(size_t from, size_t to, struct rational *multiplier, struct rational *addend)
+{
+    struct rational scale_from;
+    struct rational scale_to;
+    struct rational offset_from;
+    struct rational offset_to;
+
+    // to = (X + offset_from) * scale_from / scale_to - offset_to
+    //    = X * multiplier + addend
+    return parse_rational(scale_texts[from], &scale_from)
+        && parse_rational(scale_texts[to], &scale_to)
+        && parse_rational(offset_texts[from], &offset_from)
+        && parse_rational(offset_texts[to], &offset_to)
+        && rational_mul(scale_from, (struct rational){ scale_to.den, scale_to.num }, multiplier)
+        && rational_mul(offset_from, *multiplier, addend)
+        && rational_sub(*addend, offset_to, addend);
+}
+
+/// Prepare exact conversion from built-in unit @c from to built-in unit @c to.
+/// @return True if the scales and offsets of both units are exact rationals and the fused conversion is
+/// representable.
+static bool exact_conversion(size_t from, size_t to, struct unit_conversion *c)
+{
+    struct rational multiplier;
+    struct rational addend;
+
+    if (!rational_conversion(from, to, &multiplier, &addend)
+        || !representable(multiplier)
+        || !representable(addend)) {
+        return false;
+    }
+
+    c->exact = true;
+    c->num = (double)multiplier.num;
+    c->den = (double)multiplier.den;
+    c->multiplier = c->num / c->den;
+    c->addend = (double)addend.num / (double)addend.den;
+    c->addend_lo = fma(-c->addend, (double)addend.den, (double)addend.num) / (double)addend.den;
+    return true;
+}
+
+int unit_conversion(enum unit from, enum unit to, struct unit_conversion *c)
+{
+    const struct extension *ext;
+    size_t i;
+    size_t j;
+    enum base base;
+    double scale_from;
+    double scale_to;
+    double offset_from;
+    double offset_to;
+
+    unit_to_base(0, from, &base);
+    if (base_to_unit(0, base, to, NULL)) {
+        return -EPERM;
+    }
+
+    if (extended(from, &ext, &i)) {
+        scale_from = ext->scale[i];
+        offset_from = ext->offset[i];
+    } else {
+        i = index_of(from);
+        scale_from = scales[i];
+        offset_from = offsets[i];
+    }
+
+    if (extended(to, &ext, &j)) {
+        scale_to = ext->scale[j];
+        offset_to = ext->offset[j];
+    } else {
+        j = index_of(to);
+        scale_to = scales[j];
+        offset_to = offsets[j];
+    }
+
+    c->exact = false;
+    c->multiplier = scale_from / scale_to;
+    c->addend = offset_from * c->multiplier - offset_to;
+    c->addend_lo = 0;
+
+    if (builtin(from) && builtin(to)) {
+        exact_conversion(i, j, c);
+    }
+
+    return 0;
+}
+
+double unit_convert(const struct unit_conversion *c, double quantity)
+{
+    if (!c->exact) {
+        return quantity * c->multiplier + c->addend;
+    }
+
+    // Product as double-double, divided by the denominator with one correction step.
+    double hi = quantity * c->num;
+    double lo = fma(quantity, c->num, -hi);
+    double q = hi / c->den;
+    double r = (fma(-q, c->den, hi) + lo) / c->den;
+
+    // Add the addend, also double-double, rounding once.
+    double s = q + c->addend;
+    double v = s - q;
+    double e = (q - (s - v)) + (c->addend - v);
+
+    return s + (e + r + c->addend_lo);
+}
+
+void unit_convert_array(const struct unit_conversion *c, const double *in, double *out, size_t n)
 {
-    double X = quantity;
-    char *s = NULL;
+    if (!c->exact) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = in[i] * c->multiplier + c->addend;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = unit_convert(c, in[i]);
+    }
+}
+
+double unit_convert_tolerance(const struct unit_conversion *c, double tolerance)
+{
+    struct unit_conversion difference = *c;
+
+    difference.addend = 0;
+    difference.addend_lo = 0;
+    return fabs(unit_convert(&difference, tolerance));
+}
+
+void unit_convert_tolerance_array(const struct unit_conversion *c, const double *in, const double *tolerance_in,
+    double *out, double *tolerance_out, size_t n)
+{
+    if (!c->exact) {
+        double multiplier = fabs(c->multiplier);
+
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = in[i] * c->multiplier + c->addend;
+            tolerance_out[i] = fabs(tolerance_in[i]) * multiplier;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = unit_convert(c, in[i]);
+        tolerance_out[i] = unit_convert_tolerance(c, tolerance_in[i]);
+    }
+}
+
+/// Convert finite @c x to the rational it represents exactly, a dyadic fraction.
+/// @return True if it is representable.
+static bool dyadic(double x, struct rational *r)
+{
+    int exponent;
+    double fraction = frexp(x, &exponent);
+
+    // x = fraction * 2^exponent, where fraction * 2^53 is an integer.
+    exponent -= 53;
+    r->num = isfinite(x) ? (__int128)ldexp(fraction, 53) : 0;
+    r->den = 1;
+    return isfinite(x) && exponent >= -125 && exponent <= 72
+        && mul(r->num, (__int128)1 << (exponent > 0 ? exponent : 0), &r->num)
+        && mul(r->den, (__int128)1 << (exponent < 0 ? -exponent : 0), &r->den)
+        && reduce(r);
+}
+
+/// @return 10^@c exponent, where @c exponent is within 36 of zero.
+static struct rational power_of_ten(int exponent)
+{
+    struct rational r = { 1, 1 };
+
+    for (; exponent; exponent += exponent < 0 ? 1 : -1) {
+        *(exponent < 0 ? &r.den : &r.num) *= 10;
+    }
+
+    return r;
+}
+
+/// @return Floor of @c num / @c den, where @c den is positive.
+static __int128 floor_div(__int128 num, __int128 den)
+{
+    return num / den - (num % den != 0 && num < 0);
+}
+
+/// Largest magnitude of the numerators and denominator of a fixed-point conversion, such that twice the remainder of a
+/// conversion is within the range of int64_t.
+#define FIXED_MAX ((__int128)1 << 62)
+
+/// Greatest magnitude of the exponent of a fixed-point quantity.
+#define FIXED_EXPONENT_MAX 18
+
+int unit_conversion_fixed(enum unit from, int from_exponent, enum unit to, int to_exponent,
+    struct unit_conversion_fixed *c)
+{
+    struct unit_conversion conversion;
+    struct rational multiplier;
+    struct rational addend;
+    __int128 den;
+    __int128 num;
+    __int128 addend_num;
+    int r = unit_conversion(from, to, &conversion);
+
+    if (r) {
+        return r;
+    }
 
-    switch (unit) {
-        case PresentationUnitNone:
-        case PresentationUnitUnknown:
-            break;
+    // Built-in units convert by the rationals written in unit.hi.
+    // Otherwise, as for a scale of M_PI / 180 or a unit defined or replaced at runtime, they convert by the rationals
+    // that the multiplier and addend of their double conversion represent, which are also the same on every platform.
+    bool ok = (builtin(from) && builtin(to)
+            && rational_conversion((size_t)from, (size_t)to, &multiplier, &addend))
+        || (dyadic(conversion.multiplier, &multiplier) && dyadic(conversion.addend, &addend));
 
-#define u(symbol, name, base_, scale)            case name : if (base == base_) { X /= scale    ; asprintf(&s, "%g %ls", X, symbol); } break ;
-#define c(symbol, name, base_, tobase, frombase) case name : if (base == base_) { X  = frombase ; asprintf(&s, "%g %ls", X, symbol); } break ;
+    // Quantities are of 10^exponent of their units:
+    // to = X * multiplier * 10^(from_exponent - to_exponent) + addend * 10^-to_exponent
+    //    = (X * num + addend_num) / den
+    ok = ok
+        && abs(from_exponent) <= FIXED_EXPONENT_MAX && abs(to_exponent) <= FIXED_EXPONENT_MAX
+        && rational_mul(multiplier, power_of_ten(from_exponent - to_exponent), &multiplier)
+        && rational_mul(addend, power_of_ten(-to_exponent), &addend)
+        && mul(multiplier.den / gcd(multiplier.den, addend.den), addend.den, &den)
+        && mul(multiplier.num, den / multiplier.den, &num)
+        && mul(addend.num, den / addend.den, &addend_num)
+        && den < FIXED_MAX && num < FIXED_MAX && -num < FIXED_MAX
+        && addend_num < FIXED_MAX && -addend_num < FIXED_MAX;
+
+    if (!ok) {
+        return -ERANGE;
+    }
+
+    // Integer parts, and fractions of 2^64, of the multiplier and addend.
+    c->multiplier = (int64_t)floor_div(num, den);
+    c->multiplier_fraction =
+        (uint64_t)(((unsigned __int128)(num - c->multiplier * den) << 64) / (unsigned __int128)den);
+    c->addend = (int64_t)floor_div(addend_num, den);
+    c->addend_fraction =
+        (uint64_t)(((unsigned __int128)(addend_num - c->addend * den) << 64) / (unsigned __int128)den);
+    c->num = (int64_t)num;
+    c->addend_num = (int64_t)addend_num;
+    c->den = (int64_t)den;
+    return 0;
+}
+
+/// Convert @c x with fixed-point conversion @c c, without branches, so that loops of it may be unrolled and
+/// pipelined.
+/// @return Converted quantity, which may be out of the range of int64_t.
+static inline __int128 convert_fixed(const struct unit_conversion_fixed *c, int64_t x)
+{
+    // The fractions are truncated to 64 bits, so their sum differs from the exact fraction by less than
+    // |x| / 2^64 + 2^-64, which is less than one half, and the estimate is within one of the exact floor.
+    __int128 fraction = (__int128)x * c->multiplier_fraction + c->addend_fraction;
+    __int128 q = (__int128)x * c->multiplier + c->addend + (fraction >> 64);
+
+    // The exact remainder is in [-den, 2 * den), within the range of int64_t, so it is computed modulo 2^64.
+    int64_t rem = (int64_t)((uint64_t)x * (uint64_t)c->num + (uint64_t)c->addend_num - (uint64_t)q * (uint64_t)c->den);
+
+    // Correct the estimate to the floor, with its remainder in [0, den).
+    q -= rem < 0;
+    rem += rem < 0 ? c->den : 0;
+    q += rem >= c->den;
+    rem -= rem >= c->den ? c->den : 0;
+
+    // Round half away from zero.
+    return q + (2 * rem > c->den || (2 * rem == c->den && q >= 0));
+}
+
+int unit_convert_fixed(const struct unit_conversion_fixed *c, int64_t quantity, int64_t *out)
+{
+    return unit_convert_fixed_array(c, &quantity, out, 1);
+}
+
+int unit_convert_fixed_array(const struct unit_conversion_fixed *c, const int64_t *in, int64_t *out, size_t n)
+{
+    bool overflow = false;
+
+    for (size_t i = 0; i < n; ++i) {
+        __int128 q = convert_fixed(c, in[i]);
+
+        overflow |= q < INT64_MIN || q > INT64_MAX;
+        out[i] = q < INT64_MIN ? INT64_MIN : q > INT64_MAX ? INT64_MAX : (int64_t)q;
+    }
+
+    return overflow ? -ERANGE : 0;
+}
+
+int unit_convert_fixed_array32(const struct unit_conversion_fixed *c, const int32_t *in, int32_t *out, size_t n)
+{
+    bool overflow = false;
+
+    for (size_t i = 0; i < n; ++i) {
+        __int128 q = convert_fixed(c, in[i]);
+
+        overflow |= q < INT32_MIN || q > INT32_MAX;
+        out[i] = q < INT32_MIN ? INT32_MIN : q > INT32_MAX ? INT32_MAX : (int32_t)q;
+    }
+
+    return overflow ? -ERANGE : 0;
+}
+
+/// Part of a mixed-radix unit.
+struct part {
+    /// Mixed-radix unit.
+    enum unit unit;
+    /// Unit of part.
+    enum unit part;
+    /// Symbol of part.
+    const wchar_t *symbol;
+    /// Number of the part per one of the previous part.
+    int radix;
+    /// Denominator of fractions of the least part, or zero if it is rendered as a decimal.
+    int denominator;
+};
+
+/// Parts of mixed-radix units, from greatest to least.
+static const struct part parts[] = {
+#define r(name, part, symbol, radix, denominator) { name, part, symbol, radix, denominator },
 #include "unit.hi"
+};
+
+/// Greatest number of parts of a mixed-radix unit.
+#define PARTS_MAX 4
+
+/// @return Number of parts of @c unit, which is zero unless it is a mixed-radix unit, with the first in @c first.
+static size_t parts_of(enum unit unit, const struct part **first)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < sizeof(parts) / sizeof(*parts); ++i) {
+        if (parts[i].unit == unit && !n++) {
+            *first = &parts[i];
+        }
     }
 
-    if (unit == PresentationUnitFeetAndInches) {
-        // Exception.
-        const double ScaleFractionalFeetToInch = 12;
-        double y = fmod(X, 1) * ScaleFractionalFeetToInch;
-        free(s);
-        asprintf(&s, "%ld ' %g \"", (long)X, y);
+    return n;
+}
+
+/// @return Number of the least of @c n parts per one of the first.
+static double least_per_first(const struct part *part, size_t n)
+{
+    double scale = 1;
+
+    for (size_t i = 1; i < n; ++i) {
+        scale *= part[i].radix;
+    }
+
+    return scale;
+}
+
+bool unit_compound(enum unit first, enum unit second)
+{
+    for (size_t i = 1; i < sizeof(parts) / sizeof(*parts); ++i) {
+        if (parts[i].unit == parts[i - 1].unit && parts[i - 1].part == first
+            && (second == PresentationUnitNone || parts[i].part == second)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Append text of @c format to @c buffer of @c size bytes, of which @c *length are rendered.
+/// @c *length is advanced by the length of the text, even if it is truncated, or made negative on error.
+static void append(char *buffer, size_t size, int *length, const char *format, ...)
+{
+    size_t used = *length < 0 || (size_t)*length > size ? size : (size_t)*length;
+    va_list args;
+    int n;
+
+    va_start(args, format);
+    n = vsnprintf(buffer ? buffer + used : NULL, size - used, format, args);
+    va_end(args);
+
+    *length = *length < 0 || n < 0 ? -1 : *length + n;
+}
+
+/// Render @c quantity of a mixed-radix unit of @c n parts @c part into @c buffer of @c size bytes.
+/// Parts are counted exactly as integers of the least part, or of its fractions, so rounding carries into greater
+/// parts.
+static int format_mixed(double quantity, const struct part *part, size_t n, char *buffer, size_t size)
+{
+    const struct part *least = &part[n - 1];
+    double x = fabs(quantity) * least_per_first(part, n) * (least->denominator ? least->denominator : 1);
+    long long digits[PARTS_MAX];
+    long long numerator = 0;
+    long long count;
+    char decimal[32];
+    double least_value;
+    double scale;
+    int length = 0;
+
+    if (!(x < (double)EXACT_MAX)) {
+        // Too great to count exactly: lesser parts are below the precision of the first.
+        append(buffer, size, &length, "%g %ls", quantity, part->symbol);
+        for (size_t i = 1; isfinite(quantity) && i < n; ++i) {
+            append(buffer, size, &length, " 0 %ls", part[i].symbol);
+        }
+        return length;
+    }
+
+    if (least->denominator) {
+        count = llround(x);
+        numerator = count % least->denominator;
+        count /= least->denominator;
+    } else {
+        // The least part is rendered as a decimal of six significant digits, as by %g, which carries if it rounds to
+        // a whole radix.
+        count = (long long)x;
+        least_value = (double)(count % least->radix) + (x - (double)count);
+        scale = least_value > 0 ? pow(10, 5 - floor(log10(least_value))) : 1;
+        if (nearbyint(least_value * scale) / scale >= least->radix) {
+            count++;
+            least_value = 0;
+        }
+        snprintf(decimal, sizeof(decimal), "%g", least_value);
+    }
+
+    for (size_t i = n - 1; i > 0; --i) {
+        digits[i] = count % part[i].radix;
+        count /= part[i].radix;
+    }
+    digits[0] = count;
+
+    append(buffer, size, &length, "%s", quantity < 0 ? "-" : "");
+    for (size_t i = 0; i < n - 1; ++i) {
+        append(buffer, size, &length, "%lld %ls ", digits[i], part[i].symbol);
+    }
+
+    if (!least->denominator) {
+        append(buffer, size, &length, "%s %ls", decimal, least->symbol);
+    } else if (!numerator) {
+        append(buffer, size, &length, "%lld %ls", digits[n - 1], least->symbol);
+    } else {
+        long long g = (long long)gcd(numerator, least->denominator);
+
+        if (digits[n - 1]) {
+            append(buffer, size, &length, "%lld ", digits[n - 1]);
+        }
+        append(buffer, size, &length, "%lld/%lld %ls", numerator / g, least->denominator / g, least->symbol);
+    }
+
+    return length;
+}
+
+int unit_format(double quantity, enum unit unit, char *buffer, size_t size)
+{
+    const wchar_t *symbol = symbol_of_unit(unit);
+    const struct part *part = NULL;
+    size_t n = parts_of(unit, &part);
+
+    if (!symbol) {
+        return -EINVAL;
+    }
+
+    return n ? format_mixed(quantity, part, n, buffer, size) : snprintf(buffer, size, "%g %ls", quantity, symbol);
+}
+
+int base_format(double quantity, enum base base, enum unit unit, char *buffer, size_t size)
+{
+    double X;
+    int r = base_to_unit(quantity, base, unit, &X);
+
+    return r ? r : unit_format(X, unit, buffer, size);
+}
+
+char *unit_render(double quantity, enum unit unit)
+{
+    int n = unit_format(quantity, unit, NULL, 0);
+    char *s = n < 0 ? NULL : malloc((size_t)n + 1);
+
+    if (s) {
+        unit_format(quantity, unit, s, (size_t)n + 1);
+    }
+
+    return s;
+}
+
+char *base_render(double quantity, enum base base, enum unit unit)
+{
+    double X;
+
+    if (base_to_unit(quantity, base, unit, &X)) {
+        return NULL;
+    }
+
+    return unit_render(X, unit);
+}
+
+/// @return Plus-minus sign, or "+/-" if the locale cannot represent it.
+static const wchar_t *plus_minus(void)
+{
+    char buffer[MB_LEN_MAX];
+    mbstate_t state = { 0 };
+
+    return wcrtomb(buffer, L'±', &state) == (size_t)-1 ? L"+/-" : L"±";
+}
+
+int unit_format_tolerance(double quantity, double tolerance, enum unit unit, char *buffer, size_t size)
+{
+    const wchar_t *symbol = symbol_of_unit(unit);
+    const struct part *part = NULL;
+    size_t n = parts_of(unit, &part);
+    int length;
+
+    if (!symbol) {
+        return -EINVAL;
+    }
+
+    if (!n) {
+        return snprintf(buffer, size, "%g %ls %g %ls", quantity, plus_minus(), tolerance, symbol);
+    }
+
+    // Tolerance in the least part.
+    length = format_mixed(quantity, part, n, buffer, size);
+    append(buffer, size, &length, " %ls %g %ls", plus_minus(), tolerance * least_per_first(part, n),
+        part[n - 1].symbol);
+    return length;
+}
+
+char *unit_render_tolerance(double quantity, double tolerance, enum unit unit)
+{
+    int n = unit_format_tolerance(quantity, tolerance, unit, NULL, 0);
+    char *s = n < 0 ? NULL : malloc((size_t)n + 1);
+
+    if (s) {
+        unit_format_tolerance(quantity, tolerance, unit, s, (size_t)n + 1);
     }
 
     return s;
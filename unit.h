@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <wchar.h>
 
 /// Base units.
@@ -9,6 +12,9 @@ enum base {
 
 #define b(symbol, name) name,
 #include "unit.hi"
+
+    /// Number of built-in base units; base units defined at runtime follow.
+    BaseUnitCount
 };
 
 /// Units.
@@ -18,6 +24,9 @@ enum unit {
 
 #define u(symbol, name, base, scale) name,
 #include "unit.hi"
+
+    /// Number of built-in units; units defined at runtime follow.
+    PresentationUnitCount
 };
 
 /// @return Symbol of unit.
@@ -32,6 +41,141 @@ double unit_to_base(double quantity, enum unit unit, enum base *base);
 /// @return -EPERM If @c base cannot be converted to @c unit.
 int base_to_unit(double quantity, enum base base, enum unit unit, double *quantity_out);
 
+/// Convert @c tolerance of a quantity of @c unit to the base unit.
+/// A tolerance is a difference between quantities, so the offset of an affine unit does not apply.
+/// @return Tolerance of @c base, which is not negative.
+double unit_to_base_tolerance(double tolerance, enum unit unit, enum base *base);
+
+/// Convert @c tolerance of a quantity of @c base to the desired @c unit, without offset.
+/// @return Zero on success, negative otherwise.
+/// @return -EPERM If @c base cannot be converted to @c unit.
+int base_to_unit_tolerance(double tolerance, enum base base, enum unit unit, double *tolerance_out);
+
+/// Enumerate units of @c base, in the order listed in unit.hi followed by units defined at runtime.
+/// @param units Updated with at most @c size units; may be NULL if @c size is zero.
+/// @return Number of units of @c base, which may exceed @c size.
+size_t base_units(enum base base, enum unit *units, size_t size);
+
+/// Convert @c quantity of @c base to each of @c count @c units.
+/// @param out Updated with @c count quantities; NaN where the unit is not of @c base.
+/// @return Zero on success, negative otherwise.
+/// @return -EPERM If any unit is not of @c base.
+int base_to_units(double quantity, enum base base, const enum unit *units, size_t count, double *out);
+
+/// Conversion from one unit to another, fused into a single multiply-add.
+struct unit_conversion {
+    /// True if the conversion is exact: to = X * num / den + addend + addend_lo.
+    /// Otherwise: to = X * multiplier + addend.
+    bool exact;
+    /// Multiplier.
+    double multiplier;
+    /// Numerator and denominator of exact multiplier.
+    double num;
+    double den;
+    /// Addend.
+    double addend;
+    /// Low-order part of exact addend.
+    double addend_lo;
+};
+
+/// Prepare conversion from unit @c from to unit @c to.
+/// The conversion is exact if the scales and offsets of both units are written as exact decimals or ratios of
+/// decimals in unit.hi, and the fused multiplier and addend have numerators and denominators within 2^53.
+/// @return Zero on success, negative otherwise.
+/// @return -EPERM If @c from cannot be converted to @c to.
+int unit_conversion(enum unit from, enum unit to, struct unit_conversion *c);
+
+/// Convert @c quantity with conversion @c c.
+/// An exact conversion rounds once, from a double-double evaluation of the exact rational result.
+/// @return Converted quantity.
+double unit_convert(const struct unit_conversion *c, double quantity);
+
+/// Convert @c n quantities from @c in to @c out with conversion @c c.
+/// @c in and @c out may be the same array.
+void unit_convert_array(const struct unit_conversion *c, const double *in, double *out, size_t n);
+
+/// Convert @c tolerance with conversion @c c, without addend.
+/// @return Converted tolerance, which is not negative.
+double unit_convert_tolerance(const struct unit_conversion *c, double tolerance);
+
+/// Convert @c n quantities from @c in to @c out, and their tolerances from @c tolerance_in to @c tolerance_out,
+/// with conversion @c c, in one pass.
+/// Each output array may be the same as the corresponding input array.
+void unit_convert_tolerance_array(const struct unit_conversion *c, const double *in, const double *tolerance_in,
+    double *out, double *tolerance_out, size_t n);
+
+/// Conversion from one unit to another of integer quantities, in fixed point, so that results are exact and the
+/// same on every platform.
+/// to = round((X * num + addend_num) / den), which is estimated by the integer parts and fractions of 2^64 of the
+/// multiplier and addend, and corrected by the exact remainder.
+struct unit_conversion_fixed {
+    /// Integer part, and fraction of 2^64, of num / den.
+    int64_t multiplier;
+    uint64_t multiplier_fraction;
+    /// Integer part, and fraction of 2^64, of addend_num / den.
+    int64_t addend;
+    uint64_t addend_fraction;
+    /// Numerators of multiplier and addend, and their common denominator.
+    int64_t num;
+    int64_t addend_num;
+    int64_t den;
+};
+
+/// Prepare fixed-point conversion from integer quantities of 10^@c from_exponent of unit @c from, to integer
+/// quantities of 10^@c to_exponent of unit @c to; milli-units have an exponent of -3.
+/// Scales and offsets are the rationals written in unit.hi or, if they are not exact decimals or ratios of decimals,
+/// or a unit is defined at runtime, the rationals that their double conversion represents.
+/// @return Zero on success, negative otherwise.
+/// @return -EPERM If @c from cannot be converted to @c to.
+/// @return -ERANGE If an exponent exceeds 18 in magnitude, or the numerators or denominator exceed 2^62.
+int unit_conversion_fixed(enum unit from, int from_exponent, enum unit to, int to_exponent,
+    struct unit_conversion_fixed *c);
+
+/// Convert @c quantity with fixed-point conversion @c c, rounding to nearest, with ties away from zero.
+/// @param out Updated with the converted quantity, saturated to the range of int64_t.
+/// @return Zero on success, negative otherwise.
+/// @return -ERANGE If the converted quantity is out of range.
+int unit_convert_fixed(const struct unit_conversion_fixed *c, int64_t quantity, int64_t *out);
+
+/// Convert @c n quantities from @c in to @c out with fixed-point conversion @c c, as unit_convert_fixed.
+/// @c in and @c out may be the same array.
+/// @return -ERANGE If any converted quantity is out of range.
+int unit_convert_fixed_array(const struct unit_conversion_fixed *c, const int64_t *in, int64_t *out, size_t n);
+
+/// Convert @c n 32-bit quantities from @c in to @c out with fixed-point conversion @c c, as unit_convert_fixed,
+/// saturated to the range of int32_t.
+/// @return -ERANGE If any converted quantity is out of range.
+int unit_convert_fixed_array32(const struct unit_conversion_fixed *c, const int32_t *in, int32_t *out, size_t n);
+
+/// @return True if a quantity of unit @c first may be followed by a quantity of unit @c second, as consecutive
+/// parts of a mixed-radix unit; if @c second is PresentationUnitNone, true if any unit may follow @c first.
+bool unit_compound(enum unit first, enum unit second);
+
+/// Render @c quantity of @c unit into @c buffer of @c size bytes, without allocation.
+/// A quantity of a mixed-radix unit is rendered in its parts, such as "6 ' 3 \"".
+/// @param buffer May be NULL if @c size is zero.
+/// @return Length of the rendering, excluding the terminating NUL, as snprintf; it is truncated if not less than
+/// @c size.
+/// @return Negative if @c unit has no symbol, or the rendering cannot be represented in the current locale.
+int unit_format(double quantity, enum unit unit, char *buffer, size_t size);
+
+/// Render @c quantity of @c base as @c unit into @c buffer of @c size bytes, as unit_format.
+/// @return Negative also if @c base cannot be converted to @c unit.
+int base_format(double quantity, enum base base, enum unit unit, char *buffer, size_t size);
+
+/// Render @c quantity with @c tolerance of @c unit into @c buffer of @c size bytes, as unit_render_tolerance and
+/// unit_format.
+int unit_format_tolerance(double quantity, double tolerance, enum unit unit, char *buffer, size_t size);
+
+/// Render @c quantity of @c unit.
+/// @return Reference to string, user deallocates.
+char *unit_render(double quantity, enum unit unit);
+
 /// Render @c quantity of @c base as @c unit.
 /// @return Reference to string, user deallocates.
 char *base_render(double quantity, enum base base, enum unit unit);
+
+/// Render @c quantity with @c tolerance of @c unit, as "QUANTITY ± TOLERANCE UNIT".
+/// The tolerance of a mixed-radix unit is rendered in its least part.
+/// @return Reference to string, user deallocates.
+char *unit_render_tolerance(double quantity, double tolerance, enum unit unit);
@@ -0,0 +1,242 @@
+#include "uring.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#ifdef HAS_IO_URING
+
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// The kernel interface is used directly, through its system calls and shared rings, as liburing is not required.
+
+struct uring {
+    /// Descriptor of the instance.
+    int fd;
+    /// Shared mapping of the submission and completion rings.
+    void *ring;
+    /// Size of @c ring.
+    size_t ring_size;
+    /// Submission queue entries.
+    struct io_uring_sqe *sqes;
+    /// Size of @c sqes.
+    size_t sqes_size;
+    /// Submission ring.
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    /// Completion ring.
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    /// Number of requests queued and not yet submitted.
+    unsigned queued;
+    /// True if buffers are registered, so that requests use them without mapping each.
+    bool fixed;
+    /// Buffers.
+    char *buffers;
+    /// Size of each buffer.
+    size_t size;
+};
+
+/// Map the rings of instance @c u, described by @c p.
+/// @return Zero on success, negative otherwise.
+static int map(struct uring *u, const struct io_uring_params *p)
+{
+    char *ring;
+    int r;
+
+    // Both rings are in one mapping, as IORING_FEAT_SINGLE_MMAP is required.
+    u->ring_size = p->sq_off.array + p->sq_entries * sizeof(unsigned);
+    u->ring_size = p->cq_off.cqes + p->cq_entries * sizeof(struct io_uring_cqe) > u->ring_size
+        ? p->cq_off.cqes + p->cq_entries * sizeof(struct io_uring_cqe)
+        : u->ring_size;
+    u->sqes_size = p->sq_entries * sizeof(struct io_uring_sqe);
+
+    u->ring = mmap(NULL, u->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    u->sqes = u->ring == MAP_FAILED
+        ? MAP_FAILED
+        : mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    r = u->ring == MAP_FAILED || u->sqes == MAP_FAILED ? -ENOMEM : 0;
+
+    // Pointers into the rings are derived only once both are mapped.
+    if (!r) {
+        ring = u->ring;
+        u->sq_tail = (unsigned *)(ring + p->sq_off.tail);
+        u->sq_mask = (unsigned *)(ring + p->sq_off.ring_mask);
+        u->sq_array = (unsigned *)(ring + p->sq_off.array);
+        u->cq_head = (unsigned *)(ring + p->cq_off.head);
+        u->cq_tail = (unsigned *)(ring + p->cq_off.tail);
+        u->cq_mask = (unsigned *)(ring + p->cq_off.ring_mask);
+        u->cqes = (struct io_uring_cqe *)(ring + p->cq_off.cqes);
+    }
+
+    return r;
+}
+
+/// Features required: one mapping of both rings, and reading and writing at the file position, for pipes.
+#define FEATURES (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_RW_CUR_POS)
+
+int uring_new(unsigned count, size_t size, struct uring **out)
+{
+    struct io_uring_params p = { 0 };
+    struct uring *u = calloc(1, sizeof(*u));
+    struct iovec iov[count ? count : 1];
+    int r = u ? 0 : -ENOMEM;
+
+    if (u) {
+        u->ring = MAP_FAILED;
+        u->sqes = MAP_FAILED;
+        u->size = size;
+        u->buffers = malloc(count * size);
+        u->fd = (int)syscall(__NR_io_uring_setup, count, &p);
+        r = u->fd < 0 || (p.features & FEATURES) != FEATURES ? -ENOSYS : !u->buffers ? -ENOMEM : map(u, &p);
+    }
+
+    for (unsigned i = 0; !r && i < count; ++i) {
+        iov[i] = (struct iovec){ u->buffers + i * size, size };
+    }
+
+    if (!r) {
+        // Registration may exceed the limit of locked memory, in which case buffers are mapped for each request.
+        u->fixed = !syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_BUFFERS, iov, count);
+    }
+
+    *out = r ? (uring_delete(u), NULL) : u;
+    return r;
+}
+
+void uring_delete(struct uring *u)
+{
+    if (u) {
+        if (u->ring != MAP_FAILED) {
+            munmap(u->ring, u->ring_size);
+        }
+        if (u->sqes != MAP_FAILED) {
+            munmap(u->sqes, u->sqes_size);
+        }
+        if (u->fd >= 0) {
+            close(u->fd);
+        }
+        free(u->buffers);
+    }
+    free(u);
+}
+
+char *uring_buffer(const struct uring *u, unsigned i)
+{
+    return u->buffers + i * u->size;
+}
+
+/// Queue request @c opcode of @c length bytes of buffer @c i from byte @c at, for @c fd at @c offset.
+static void queue(struct uring *u, int opcode, int fd, unsigned i, size_t at, size_t length, int64_t offset)
+{
+    // Only this thread adds to the submission ring; the kernel reads the tail.
+    unsigned tail = *u->sq_tail;
+    unsigned index = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (uint8_t)opcode;
+    sqe->fd = fd;
+    sqe->off = (uint64_t)offset;
+    sqe->addr = (uint64_t)(uintptr_t)(uring_buffer(u, i) + at);
+    sqe->len = (uint32_t)length;
+    sqe->buf_index = (uint16_t)i;
+    sqe->user_data = i;
+
+    u->sq_array[index] = index;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    u->queued++;
+}
+
+void uring_read(struct uring *u, int fd, unsigned i, size_t at, size_t length, int64_t offset)
+{
+    queue(u, u->fixed ? IORING_OP_READ_FIXED : IORING_OP_READ, fd, i, at, length, offset);
+}
+
+void uring_write(struct uring *u, int fd, unsigned i, size_t at, size_t length, int64_t offset)
+{
+    queue(u, u->fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, fd, i, at, length, offset);
+}
+
+int uring_complete(struct uring *u, bool wait, unsigned *i, int *result)
+{
+    // Only this thread removes from the completion ring; the kernel writes the tail.
+    unsigned head = *u->cq_head;
+    bool ready;
+    int r = 0;
+
+    // Submit, and wait if asked; an interrupted wait is retried.
+    while (!(ready = head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) && !r && (wait || u->queued)) {
+        int n = (int)syscall(__NR_io_uring_enter, u->fd, u->queued, wait ? 1 : 0,
+            wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+
+        r = n >= 0 || errno == EINTR ? 0 : -errno;
+        u->queued -= n > 0 ? (unsigned)n : 0;
+    }
+
+    if (ready) {
+        const struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+
+        *i = (unsigned)cqe->user_data;
+        *result = cqe->res;
+        __atomic_store_n(u->cq_head, head + 1, __ATOMIC_RELEASE);
+        r = 1;
+    }
+
+    return r;
+}
+
+#else
+
+int uring_new(unsigned count, size_t size, struct uring **out)
+{
+    (void)count;
+    (void)size;
+    *out = NULL;
+    return -ENOSYS;
+}
+
+void uring_delete(struct uring *u)
+{
+    free(u);
+}
+
+char *uring_buffer(const struct uring *u, unsigned i)
+{
+    (void)u;
+    (void)i;
+    return NULL;
+}
+
+void uring_read(struct uring *u, int fd, unsigned i, size_t at, size_t length, int64_t offset)
+{
+    (void)u;
+    (void)fd;
+    (void)i;
+    (void)at;
+    (void)length;
+    (void)offset;
+}
+
+void uring_write(struct uring *u, int fd, unsigned i, size_t at, size_t length, int64_t offset)
+{
+    uring_read(u, fd, i, at, length, offset);
+}
+
+int uring_complete(struct uring *u, bool wait, unsigned *i, int *result)
+{
+    (void)u;
+    (void)wait;
+    (void)i;
+    (void)result;
+    return -ENOSYS;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Linux io_uring instance, with a buffer for each request in flight.
+/// Requests are identified by their buffer, so a buffer has at most one request in flight.
+struct uring;
+
+/// Make an io_uring instance with @c count buffers of @c size bytes, registered with the kernel if possible.
+/// @return Zero on success, negative otherwise.
+/// @return -ENOSYS If io_uring is not available, or does not support reading or writing at the file position.
+/// @return -ENOMEM If memory is exhausted.
+int uring_new(unsigned count, size_t size, struct uring **out);
+
+/// Delete @c u, which must have no requests in flight.
+void uring_delete(struct uring *u);
+
+/// @return Buffer @c i.
+char *uring_buffer(const struct uring *u, unsigned i);
+
+/// Queue a read of @c length bytes from @c fd at @c offset, or at the file position if @c offset is -1, into buffer
+/// @c i from byte @c at.
+void uring_read(struct uring *u, int fd, unsigned i, size_t at, size_t length, int64_t offset);
+
+/// Queue a write of @c length bytes of buffer @c i from byte @c at to @c fd at @c offset, or at the file position if
+/// @c offset is -1.
+void uring_write(struct uring *u, int fd, unsigned i, size_t at, size_t length, int64_t offset);
+
+/// Submit queued requests, and reap a completion, waiting for one if @c wait.
+/// @return One if a request completed, with its buffer in @c i and its result, as read or write, in @c result;
+/// zero if none has completed and @c wait is false; negative on failure.
+int uring_complete(struct uring *u, bool wait, unsigned *i, int *result);